@@ -0,0 +1,358 @@
+/*!
+  Measures serial against parallel construction, compares the trie backends
+  on prefix descent and measures how full traversals scale with the number
+  of workers. Also pits sessions on one
+  shared trie against the sharded, message passing trie under concurrent
+  clients, the symmetric delete index against fuzzy trie matching, and
+  glob pattern queries against enumerating and filtering every word.
+  Usage: autocomplete_benchmark [word file]
+  Without a file a deterministic synthetic word list is generated.
+ */
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "lib/include/timer.hpp"
+
+#include "lib/src/DeletionIndex.hpp"
+#include "lib/src/GlobPattern.hpp"
+#include "lib/src/QuerySession.hpp"
+#include "lib/src/ShardedTrie.hpp"
+#include "lib/src/Trie.hpp"
+
+tool_n::Timer timer;
+
+constexpr size_t kRepetitions = 5;
+
+std::vector< std::string > loadWords( int argc, char** argv )
+{
+  std::vector< std::string > words;
+  if ( argc > 1 )
+  {
+    std::ifstream file( argv[ 1 ] );
+    std::string line;
+    while ( std::getline( file, line ) )
+      words.push_back( line );
+    return words;
+  }
+
+  std::mt19937 rng( 42 );
+  for ( size_t i = 0; i < 500000; ++i )
+  {
+    std::string word( 3 + rng() % 10, ' ' );
+    for ( auto& letter : word )
+      letter = static_cast< char >( 'a' + rng() % 26 );
+    words.push_back( word );
+  }
+  return words;
+}
+
+std::unique_ptr< Trie_c > buildTrie( const std::vector< std::string >& words,
+    TrieLayout_t layout, size_t numWorkers = 1 )
+{
+  auto trie = std::make_unique< Trie_c >( numWorkers, layout );
+  for ( const auto& word : words )
+    trie->insertWord( word );
+  return trie;
+}
+
+void benchmarkBuild( const std::vector< std::string >& words, size_t numWorkers )
+{
+  std::vector< WordEntry_t > entries;
+  for ( const auto& word : words )
+    entries.push_back( { word, 1 } );
+
+  const std::string name = "build, " + std::to_string( numWorkers ) + " workers";
+  size_t numNodes = 0;
+  for ( size_t rep = 0; rep < kRepetitions; ++rep )
+  {
+    Trie_c trie( numWorkers );
+    timer.start( name );
+    trie.insertWords( entries );
+    timer.stop( name );
+    numNodes = trie.nodeCount();
+  }
+  std::cout << name << ": " << numNodes << " nodes\n";
+}
+
+void benchmarkSortedBuild( std::vector< std::string > words )
+{
+  std::sort( words.begin(), words.end() );
+  std::vector< WordEntry_t > entries;
+  for ( const auto& word : words )
+    entries.push_back( { word, 1 } );
+
+  for ( const TrieLayout_t layout : { TrieLayout_t::Plain, TrieLayout_t::Radix } )
+  {
+    const std::string name = layout == TrieLayout_t::Plain
+      ? "build sorted" : "build sorted radix";
+    size_t numNodes = 0;
+    for ( size_t rep = 0; rep < kRepetitions; ++rep )
+    {
+      Trie_c trie( 1, layout );
+      timer.start( name );
+      trie.buildFromSorted( entries );
+      timer.stop( name );
+      numNodes = trie.nodeCount();
+    }
+    std::cout << name << ": " << numNodes << " nodes\n";
+  }
+}
+
+void benchmarkDescent( const std::string& name, const Trie_c& trie,
+    const std::vector< std::string >& words )
+{
+  size_t found = 0;
+  for ( size_t rep = 0; rep < kRepetitions; ++rep )
+  {
+    timer.start( name );
+    for ( const auto& word : words )
+    {
+      // every prefix of every word, so each query descends one byte further
+      std::string prefix;
+      for ( const char letter : word )
+      {
+        prefix.push_back( letter );
+        found += trie.containsPrefix( prefix );
+      }
+    }
+    timer.stop( name );
+  }
+  std::cout << name << ": " << trie.memoryUsage() << " bytes, "
+    << found / kRepetitions << " prefixes found\n";
+}
+
+void benchmarkTraversal( const std::vector< std::string >& words, size_t numWorkers )
+{
+  const auto trie = buildTrie( words, TrieLayout_t::Plain, numWorkers );
+
+  std::mutex access;
+  std::condition_variable finished;
+  bool done = false;
+  size_t numMatches = 0;
+  trie->setCallback( [ & ]( const std::vector< std::string >& result )
+  {
+    std::lock_guard< std::mutex > guard( access );
+    numMatches = result.size();
+    done = true;
+    finished.notify_one();
+  } );
+
+  const std::string name = "traverse all, " + std::to_string( numWorkers ) + " workers";
+  for ( size_t rep = 0; rep < kRepetitions; ++rep )
+  {
+    timer.start( name );
+    trie->findPrefixMatches( "" );
+    std::unique_lock< std::mutex > lock( access );
+    finished.wait( lock, [ & ] { return done; } );
+    done = false;
+    timer.stop( name );
+  }
+  std::cout << name << ": " << numMatches << " matches\n";
+}
+
+// blocks until a query posted by 'start' reported its matches
+size_t waitForMatches( const std::function< void( ShardedTrie_c::callback ) >& start )
+{
+  std::mutex access;
+  std::condition_variable finished;
+  bool done = false;
+  size_t numMatches = 0;
+  start( [ & ]( const std::vector< std::string >& result )
+  {
+    std::lock_guard< std::mutex > guard( access );
+    numMatches = result.size();
+    done = true;
+    finished.notify_one();
+  } );
+  std::unique_lock< std::mutex > lock( access );
+  finished.wait( lock, [ & ] { return done; } );
+  return numMatches;
+}
+
+/*!
+  'numClients' threads each enumerate the matches of the two-byte prefixes
+  of the first words, once through a session per client on a shared trie and
+  once through a trie with one shard per client.
+  */
+void benchmarkConcurrentQueries( const std::vector< std::string >& words, size_t numClients )
+{
+  std::vector< std::string > prefixes;
+  for ( size_t i = 0; i < words.size() && prefixes.size() < 2000; ++i )
+    prefixes.push_back( words[ i ].substr( 0, 2 ) );
+
+  const auto runClients = [ & ]( const std::string& name,
+      const std::function< size_t( size_t ) >& client )
+  {
+    std::vector< size_t > matches( numClients );
+    timer.start( name );
+    std::vector< std::thread > clients;
+    for ( size_t c = 0; c < numClients; ++c )
+      clients.emplace_back( [ &, c ] { matches[ c ] = client( c ); } );
+    for ( auto& thread : clients )
+      thread.join();
+    timer.stop( name );
+    std::cout << name << ": " << matches.front() << " matches per client\n";
+  };
+
+  const auto shared = buildTrie( words, TrieLayout_t::Radix, numClients );
+  runClients( "sessions, " + std::to_string( numClients ) + " clients", [ & ]( size_t )
+  {
+    QuerySession_c session( *shared );
+    size_t numMatches = 0;
+    for ( const auto& prefix : prefixes )
+      numMatches += waitForMatches( [ & ]( ShardedTrie_c::callback done )
+      {
+        session.setCallback( done );
+        session.findPrefixMatches( prefix );
+      } );
+    return numMatches;
+  } );
+
+  ShardedTrie_c sharded( words, numClients );
+  runClients( "shards, " + std::to_string( numClients ) + " clients", [ & ]( size_t )
+  {
+    size_t numMatches = 0;
+    for ( const auto& prefix : prefixes )
+      numMatches += waitForMatches( [ & ]( ShardedTrie_c::callback done )
+      {
+        sharded.findPrefixMatches( prefix, done );
+      } );
+    return numMatches;
+  } );
+}
+
+/*!
+  Corrects misspelled words, each with up to two random edits, with the
+  symmetric delete index and with a fuzzy descent of the trie. The trie also
+  completes the misspellings, so it reports more words.
+  */
+void benchmarkCorrections( const std::vector< std::string >& words )
+{
+  std::mt19937 rng( 7 );
+  std::vector< std::string > typos;
+  for ( size_t i = 0; i < words.size() && typos.size() < 1000; i += 97 )
+  {
+    std::string typo = words[ i ];
+    for ( size_t edit = rng() % 3; edit > 0 && !typo.empty(); --edit )
+    {
+      const size_t at = rng() % typo.size();
+      const char letter = static_cast< char >( 'a' + rng() % 26 );
+      switch ( rng() % 3 )
+      {
+        case 0: typo[ at ] = letter; break;
+        case 1: typo.erase( at, 1 ); break;
+        default: typo.insert( typo.begin() + at, letter ); break;
+      }
+    }
+    typos.push_back( typo );
+  }
+
+  timer.start( "corrections index build" );
+  const DeletionIndex_c index( std::vector< std::string_view >( words.begin(), words.end() ) );
+  timer.stop( "corrections index build" );
+  std::cout << "corrections index: " << index.memoryUsage() << " bytes, distance "
+    << index.maxDistance() << "\n";
+
+  size_t found = 0;
+  for ( size_t rep = 0; rep < kRepetitions; ++rep )
+  {
+    timer.start( "corrections index" );
+    for ( const auto& typo : typos )
+      found += index.lookup( typo, 2 ).size();
+    timer.stop( "corrections index" );
+  }
+  std::cout << "corrections index: " << found / kRepetitions << " suggestions\n";
+
+  const auto trie = buildTrie( words, TrieLayout_t::Radix );
+  found = 0;
+  for ( size_t rep = 0; rep < kRepetitions; ++rep )
+  {
+    timer.start( "corrections fuzzy trie" );
+    for ( const auto& typo : typos )
+      found += trie->findFuzzyPrefixMatches( typo, 2 ).size();
+    timer.stop( "corrections fuzzy trie" );
+  }
+  std::cout << "corrections fuzzy trie: " << found / kRepetitions << " matches\n";
+}
+
+void benchmarkPatterns( const std::vector< std::string >& words, size_t numWorkers )
+{
+  const std::vector< std::string > patterns = { "c?a*ge", "*ing", "a*b*c", "[aeiou]??[!e]*", "st*" };
+  const auto trie = buildTrie( words, TrieLayout_t::Radix, numWorkers );
+
+  const std::string name = "patterns, " + std::to_string( numWorkers ) + " workers";
+  size_t found = 0;
+  for ( size_t rep = 0; rep < kRepetitions; ++rep )
+  {
+    timer.start( name );
+    for ( const auto& pattern : patterns )
+      found += trie->findPatternMatches( pattern ).size();
+    timer.stop( name );
+  }
+  std::cout << name << ": " << found / kRepetitions << " matches\n";
+
+  if ( numWorkers > 1 )
+    return;
+  found = 0;
+  for ( size_t rep = 0; rep < kRepetitions; ++rep )
+  {
+    timer.start( "patterns, filtered" );
+    std::vector< std::string > all;
+    trie->collectPrefixMatches( "", all );
+    for ( const auto& pattern : patterns )
+    {
+      const GlobPattern_c glob( pattern );
+      found += std::count_if( all.begin(), all.end(),
+          [ & ]( const std::string& word ) { return glob.matches( word ); } );
+    }
+    timer.stop( "patterns, filtered" );
+  }
+  std::cout << "patterns, filtered: " << found / kRepetitions << " matches\n";
+}
+
+int main( int argc, char** argv )
+{
+  const std::vector< std::string > words = loadWords( argc, argv );
+  std::cout << "words: " << words.size() << "\n";
+
+  for ( const size_t numWorkers : { 1, 2, 4, 8 } )
+    benchmarkBuild( words, numWorkers );
+  benchmarkSortedBuild( words );
+
+  const auto plain = buildTrie( words, TrieLayout_t::Plain );
+  benchmarkDescent( "descent arena", *plain, words );
+
+  const auto radix = buildTrie( words, TrieLayout_t::Radix );
+  benchmarkDescent( "descent arena radix", *radix, words );
+
+  // the arena is released, so memoryUsage() is that of the frozen layout alone
+  const auto louds = buildTrie( words, TrieLayout_t::Radix );
+  louds->freeze( FrozenLayout_t::Louds );
+  benchmarkDescent( "descent louds", *louds, words );
+
+  const auto doubleArray = buildTrie( words, TrieLayout_t::Radix );
+  doubleArray->freeze( FrozenLayout_t::DoubleArray );
+  benchmarkDescent( "descent double array", *doubleArray, words );
+
+  for ( const size_t numWorkers : { 1, 2, 4, 8 } )
+    benchmarkTraversal( words, numWorkers );
+
+  for ( const size_t numClients : { 1, 4 } )
+    benchmarkConcurrentQueries( words, numClients );
+
+  benchmarkCorrections( words );
+
+  for ( const size_t numWorkers : { 1, 4 } )
+    benchmarkPatterns( words, numWorkers );
+
+  std::cout << timer << "\n";
+}
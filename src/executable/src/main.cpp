@@ -6,15 +6,15 @@
   Given a set of words(strings), a trie represents these with paths from the root
   to its leaf nodes. A word in the set is allowed to be a prefix of another word.
  */
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include "lib/include/timer.hpp"
 
 #include "lib/src/Dictionary.hpp"
 
-// oje, global
-bool askAgain = false;
 tool_n::Timer timer;
 
 const std::string trieTraverseTimer = "trie traverse time";
@@ -40,14 +40,6 @@ bool promptUser( const std::string& question )
 
 void outputResult( const std::vector< std::string >& result )
 {
-  timer.stop( trieTraverseTimer );
-  std::cout << "found " << result.size() << " words with this prefix."
-        << std::endl;
-  if ( !promptUser("Shall I print them?") )
-  {
-    askAgain = true;
-    return;
-  }
   std::cout << "------------------------------------------\n";
   for ( const auto& matchWord : result )
   {
@@ -55,21 +47,32 @@ void outputResult( const std::vector< std::string >& result )
   }
 
   std::cout << "------------------------------------------" << std::endl;
-  askAgain = true;
 }
 
 int main() {
-  using namespace std::chrono_literals;
-
   const std::string filePath =
     "charlesDickens.txt";
 
   Dictionary_c dictionary;
-  dictionary.initDictionary( filePath );
+  LoadStats_t stats;
+  try
+  {
+    stats = dictionary.initDictionary( filePath );
+  }
+  catch ( const std::runtime_error& )
+  {
+    std::cout << "Unable to open file" << std::endl;
+    return 1;
+  }
+  const double megabytes = stats._bytes / ( 1024.0 * 1024.0 );
+  std::cout << "loaded " << stats._words << " words (" << megabytes << " MB) in "
+    << stats._seconds * 1000.0 << " ms, " << megabytes / std::max( stats._seconds, 1e-9 )
+    << " MB/s" << std::endl;
 
   std::unique_ptr< Trie_c > triePtr = std::move( dictionary._trie );
-  const auto cb = std::bind( &outputResult, std::placeholders::_1 );
-  triePtr->setCallback( cb );
+  // the dictionary is read-only from here on, and only counted and
+  // enumerated: the node arena is not needed any more
+  triePtr->freeze( FrozenLayout_t::Louds, false );
   std::string prefix;
 
   do
@@ -77,13 +80,17 @@ int main() {
     std::cout << "Enter a prefix: " << std::endl;
     std::getline( std::cin, prefix );
     timer.start( trieTraverseTimer );
-    triePtr->findPrefixMatches( prefix );
+    const size_t numMatches = triePtr->countPrefixMatches( prefix );
+    timer.stop( trieTraverseTimer );
 
-    while ( !askAgain )
+    std::cout << "found " << numMatches << " words with this prefix."
+        << std::endl;
+    // only enumerate the words if someone wants to read them
+    if ( numMatches > 0 && promptUser( "Shall I print them?" ) )
     {
-      std::this_thread::sleep_for( 5ms );
+      // blocks until the search is done, no polling
+      outputResult( triePtr->findPrefixMatches( prefix ).get() );
     }
-    askAgain = false;
   } while ( promptUser( "Would you like to continue?" ) );
   std::cout << timer << "\n";
 }
\ No newline at end of file
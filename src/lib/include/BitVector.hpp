@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+/*!
+  Append-only bit vector with rank/select support.
+  Call build() once after the last push_back and before any rank/select.
+  Ranks are sampled every 512 bits (one uint32_t per 8 words), select does a
+  binary search over those samples and finishes with a popcount scan.
+  */
+class BitVector_c
+{
+public:
+  void push_back( bool bit )
+  {
+    if ( ( _size & 63 ) == 0 )
+      _words.push_back( 0 );
+    if ( bit )
+      _words.back() |= uint64_t( 1 ) << ( _size & 63 );
+    ++_size;
+  }
+
+  bool operator[]( size_t pos ) const
+  {
+    return ( _words[ pos >> 6 ] >> ( pos & 63 ) ) & 1;
+  }
+
+  size_t size() const { return _size; }
+  size_t ones() const { return _ones; }
+
+  size_t memoryUsage() const
+  {
+    return _words.capacity() * sizeof( uint64_t )
+      + _blockRanks.capacity() * sizeof( uint32_t );
+  }
+
+  void build()
+  {
+    if ( _size >= std::numeric_limits< uint32_t >::max() )
+      throw std::length_error( "BitVector_c: too many bits for 32-bit ranks" );
+
+    _words.shrink_to_fit();
+    _blockRanks.assign( _words.size() / kWordsPerBlock + 1, 0 );
+    uint32_t ones = 0;
+    for ( size_t w = 0; w < _words.size(); ++w )
+    {
+      if ( w % kWordsPerBlock == 0 )
+        _blockRanks[ w / kWordsPerBlock ] = ones;
+      ones += static_cast< uint32_t >( __builtin_popcountll( _words[ w ] ) );
+    }
+    if ( _words.size() % kWordsPerBlock == 0 )
+      _blockRanks.back() = ones;
+    _ones = ones;
+  }
+
+  // number of ones in [0, pos)
+  size_t rank1( size_t pos ) const
+  {
+    const size_t word = pos >> 6;
+    const size_t block = word / kWordsPerBlock;
+    size_t ones = _blockRanks[ block ];
+    for ( size_t w = block * kWordsPerBlock; w < word; ++w )
+      ones += __builtin_popcountll( _words[ w ] );
+    if ( pos & 63 )
+      ones += __builtin_popcountll( _words[ word ] & ( ( uint64_t( 1 ) << ( pos & 63 ) ) - 1 ) );
+    return ones;
+  }
+
+  // number of zeros in [0, pos)
+  size_t rank0( size_t pos ) const { return pos - rank1( pos ); }
+
+  // position of the zero that has exactly 'k' zeros before it
+  size_t select0( size_t k ) const
+  {
+    // last block with fewer than k+1 zeros in front of it
+    size_t lo = 0;
+    size_t hi = _blockRanks.size();
+    while ( hi - lo > 1 )
+    {
+      const size_t mid = ( lo + hi ) / 2;
+      if ( mid * kBitsPerBlock - _blockRanks[ mid ] <= k )
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+    size_t remaining = k - ( lo * kBitsPerBlock - _blockRanks[ lo ] );
+    for ( size_t w = lo * kWordsPerBlock; w < _words.size(); ++w )
+    {
+      uint64_t zeros = ~_words[ w ];
+      const size_t count = __builtin_popcountll( zeros );
+      if ( remaining < count )
+      {
+        for ( size_t i = 0; i < remaining; ++i )
+          zeros &= zeros - 1;
+        return ( w << 6 ) + __builtin_ctzll( zeros );
+      }
+      remaining -= count;
+    }
+    return _size;
+  }
+
+private:
+  static constexpr size_t kWordsPerBlock = 8;
+  static constexpr size_t kBitsPerBlock = kWordsPerBlock * 64;
+
+  std::vector< uint64_t > _words;
+  std::vector< uint32_t > _blockRanks;
+  size_t _size = 0;
+  size_t _ones = 0;
+};
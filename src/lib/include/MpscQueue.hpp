@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+
+/*!
+  Intrusive lock-free queue for many producers and a single consumer
+  (D. Vyukov's design). T needs a member std::atomic< T* > _next. push() is
+  one exchange and one store and never blocks; pop() may only be called by
+  the consumer and returns nullptr when the queue is empty or a push is half
+  way done. The queue does not own its elements.
+  */
+template < class T >
+class MpscQueue_c
+{
+public:
+  MpscQueue_c() : _head( &_stub ), _tail( &_stub ) {}
+  MpscQueue_c( const MpscQueue_c& ) = delete;
+
+  void push( T* element )
+  {
+    element->_next.store( nullptr, std::memory_order_relaxed );
+    // sequentially consistent, so a consumer going to sleep either sees the
+    // element or its producer sees the sleeper
+    T* previous = _head.exchange( element );
+    previous->_next.store( element, std::memory_order_release );
+  }
+
+  T* pop()
+  {
+    T* tail = _tail;
+    T* next = tail->_next.load( std::memory_order_acquire );
+    if ( tail == &_stub )
+    {
+      if ( !next )
+        return nullptr;
+      _tail = next;
+      tail = next;
+      next = next->_next.load( std::memory_order_acquire );
+    }
+    if ( next )
+    {
+      _tail = next;
+      return tail;
+    }
+
+    // 'tail' is the last element, unless a producer is linking a new one
+    if ( tail != _head.load() )
+      return nullptr;
+    // put the stub behind it, so 'tail' can be handed out
+    push( &_stub );
+    next = tail->_next.load( std::memory_order_acquire );
+    if ( next )
+    {
+      _tail = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+  // consumer side only. False while a push is in progress, even if pop()
+  // cannot hand out the element yet.
+  bool empty() const
+  {
+    return _tail == &_stub && _head.load() == &_stub;
+  }
+
+private:
+  // producers and the consumer work on different cache lines
+  alignas( 64 ) std::atomic< T* > _head;
+  alignas( 64 ) T* _tail;
+  T _stub;
+};
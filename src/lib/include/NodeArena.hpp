@@ -0,0 +1,521 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+#include "include/TrieNode.hpp"
+
+/*!
+  Contiguous storage for all nodes of a trie.
+  Index 0 is always the root. Nodes are never freed individually, the whole
+  arena is released at once by clear() or on destruction.
+
+  Children are kept in adaptive containers (Node4/16/48/256) held in one pool
+  per container type. A node is moved to the next larger container when it
+  runs out of room; the old slot is recycled. All child iteration is in
+  ascending key order, so a depth-first walk visits words lexicographically.
+  */
+class NodeArena_c
+{
+public:
+  NodeArena_c() { clear(); }
+  NodeArena_c( const NodeArena_c& ) = delete;
+
+  NodeIndex_t root() const { return 0; }
+
+  const TrieNode_t& operator[]( NodeIndex_t index ) const { return _nodes[ index ]; }
+  TrieNode_t& operator[]( NodeIndex_t index ) { return _nodes[ index ]; }
+
+  size_t size() const { return _nodes.size(); }
+  size_t memoryUsage() const
+  {
+    return _nodes.capacity() * sizeof( TrieNode_t ) + _labels.capacity()
+      + _node4.memoryUsage() + _node16.memoryUsage()
+      + _node48.memoryUsage() + _node256.memoryUsage();
+  }
+
+  void reserve( size_t numNodes ) { _nodes.reserve( numNodes ); }
+
+  void clear()
+  {
+    std::vector< TrieNode_t >().swap( _nodes );
+    std::string().swap( _labels );
+    _node4 = Pool_t< Node4_t >();
+    _node16 = Pool_t< Node16_t >();
+    _node48 = Pool_t< Node48_t >();
+    _node256 = Pool_t< Node256_t >();
+    _nodes.emplace_back();
+  }
+
+  std::string_view label( NodeIndex_t index ) const
+  {
+    const TrieNode_t& node = _nodes[ index ];
+    if ( node._labelLength <= 1 )
+      return std::string_view( &node._letter, node._labelLength );
+    return std::string_view( _labels.data() + node._labelBegin, node._labelLength );
+  }
+
+  size_t childCount( NodeIndex_t parent ) const { return _nodes[ parent ]._childCount; }
+
+  NodeIndex_t findChild( NodeIndex_t parent, char letter ) const
+  {
+    const TrieNode_t& node = _nodes[ parent ];
+    const auto key = static_cast< uint8_t >( letter );
+    switch ( node._childKind )
+    {
+      case ChildKind_t::None:
+        return kNullNode;
+      case ChildKind_t::Node4:
+      {
+        const Node4_t& n = _node4[ node._children ];
+        const int slot = findKey( n._keys, node._childCount, key );
+        return slot < 0 ? kNullNode : n._children[ slot ];
+      }
+      case ChildKind_t::Node16:
+      {
+        const Node16_t& n = _node16[ node._children ];
+        const int slot = findKey( n._keys, node._childCount, key );
+        return slot < 0 ? kNullNode : n._children[ slot ];
+      }
+      case ChildKind_t::Node48:
+      {
+        const Node48_t& n = _node48[ node._children ];
+        return n._index[ key ] ? n._children[ n._index[ key ] - 1 ] : kNullNode;
+      }
+      case ChildKind_t::Node256:
+        return _node256[ node._children ]._children[ key ];
+    }
+    return kNullNode;
+  }
+
+  // calls f( NodeIndex_t child ) for every child in ascending key order
+  template< class F >
+  void forEachChild( NodeIndex_t parent, F&& f ) const
+  {
+    const TrieNode_t& node = _nodes[ parent ];
+    switch ( node._childKind )
+    {
+      case ChildKind_t::None:
+        break;
+      case ChildKind_t::Node4:
+      {
+        const Node4_t& n = _node4[ node._children ];
+        for ( size_t i = 0; i < node._childCount; ++i )
+          f( n._children[ i ] );
+        break;
+      }
+      case ChildKind_t::Node16:
+      {
+        const Node16_t& n = _node16[ node._children ];
+        for ( size_t i = 0; i < node._childCount; ++i )
+          f( n._children[ i ] );
+        break;
+      }
+      case ChildKind_t::Node48:
+      {
+        const Node48_t& n = _node48[ node._children ];
+        for ( size_t key = 0; key < 256; ++key )
+          if ( n._index[ key ] )
+            f( n._children[ n._index[ key ] - 1 ] );
+        break;
+      }
+      case ChildKind_t::Node256:
+      {
+        const Node256_t& n = _node256[ node._children ];
+        for ( size_t key = 0; key < 256; ++key )
+          if ( n._children[ key ] != kNullNode )
+            f( n._children[ key ] );
+        break;
+      }
+    }
+  }
+
+  /*!
+    Child iteration one step at a time, in ascending key order. 'cursor'
+    starts at 0 and is advanced by every call; returns kNullNode once all
+    children were handed out.
+    */
+  NodeIndex_t nextChild( NodeIndex_t parent, uint32_t& cursor ) const
+  {
+    const TrieNode_t& node = _nodes[ parent ];
+    switch ( node._childKind )
+    {
+      case ChildKind_t::None:
+        break;
+      case ChildKind_t::Node4:
+        if ( cursor < node._childCount )
+          return _node4[ node._children ]._children[ cursor++ ];
+        break;
+      case ChildKind_t::Node16:
+        if ( cursor < node._childCount )
+          return _node16[ node._children ]._children[ cursor++ ];
+        break;
+      case ChildKind_t::Node48:
+      {
+        // the cursor is the next key to look at
+        const Node48_t& n = _node48[ node._children ];
+        for ( ; cursor < 256; ++cursor )
+          if ( n._index[ cursor ] )
+            return n._children[ n._index[ cursor++ ] - 1 ];
+        break;
+      }
+      case ChildKind_t::Node256:
+      {
+        const Node256_t& n = _node256[ node._children ];
+        for ( ; cursor < 256; ++cursor )
+          if ( n._children[ cursor ] != kNullNode )
+            return n._children[ cursor++ ];
+        break;
+      }
+    }
+    return kNullNode;
+  }
+
+  NodeIndex_t findOrAddChild( NodeIndex_t parent, char letter )
+  {
+    const NodeIndex_t existing = findChild( parent, letter );
+    if ( existing != kNullNode )
+      return existing;
+
+    const NodeIndex_t added = allocate();
+    _nodes[ added ]._letter = letter;
+    _nodes[ added ]._labelLength = 1;
+    insertChild( parent, static_cast< uint8_t >( letter ), added );
+    return added;
+  }
+
+  /*!
+    Adds a child whose edge carries the whole (non-empty) label.
+    The caller guarantees that no child starting with label[0] exists yet.
+    */
+  NodeIndex_t addChild( NodeIndex_t parent, std::string_view label )
+  {
+    const NodeIndex_t added = allocate();
+    _nodes[ added ]._letter = label.front();
+    _nodes[ added ]._labelLength = 1;
+    insertChild( parent, static_cast< uint8_t >( label.front() ), added );
+    if ( label.size() > 1 )
+    {
+      if ( _labels.size() + label.size() > std::numeric_limits< uint32_t >::max() )
+        throw std::length_error( "NodeArena_c: label pool exhausted" );
+      _nodes[ added ]._labelBegin = static_cast< uint32_t >( _labels.size() );
+      _nodes[ added ]._labelLength = static_cast< uint32_t >( label.size() );
+      _labels.append( label );
+    }
+    return added;
+  }
+
+  /*!
+    Splits the edge into 'index' after 'at' bytes of its label. 'index' keeps
+    the first part of the label and its place in its parent, a new node
+    takes over the rest of the label, the children and the leaf flag.
+    Returns the new lower node.
+    */
+  NodeIndex_t splitLabel( NodeIndex_t index, uint32_t at )
+  {
+    const NodeIndex_t lower = allocate();
+    TrieNode_t& upper = _nodes[ index ];
+    TrieNode_t& tail = _nodes[ lower ];
+
+    tail._labelBegin = upper._labelBegin + at;
+    tail._labelLength = upper._labelLength - at;
+    tail._letter = _labels[ tail._labelBegin ];
+    tail._children = upper._children;
+    tail._childCount = upper._childCount;
+    tail._childKind = upper._childKind;
+    tail._isLeaf = upper._isLeaf;
+    tail._wordCount = upper._wordCount;
+    tail._weight = upper._weight;
+    tail._maxWeight = upper._maxWeight;
+
+    upper._labelLength = at;
+    upper._children = kNullNode;
+    upper._childCount = 0;
+    upper._childKind = ChildKind_t::None;
+    upper._isLeaf = false;
+    upper._weight = 0;
+
+    insertChild( index, static_cast< uint8_t >( tail._letter ), lower );
+    return lower;
+  }
+
+  /*!
+    Copies all nodes of 'other' into this arena and hangs the children of its
+    root below our root, relocating node indices, label offsets and container
+    slots on the way. No child of our root may start with the same byte as a
+    child of the root of 'other'. Word counts and weights of the two roots
+    are combined, the root of 'other' itself is not copied.
+    */
+  void graft( const NodeArena_c& other )
+  {
+    if ( _nodes.size() + other._nodes.size() > kNullNode )
+      throw std::length_error( "NodeArena_c: node index space exhausted" );
+    if ( _labels.size() + other._labels.size() > std::numeric_limits< uint32_t >::max() )
+      throw std::length_error( "NodeArena_c: label pool exhausted" );
+
+    // node i > 0 of 'other' becomes node base + i
+    const NodeIndex_t base = static_cast< NodeIndex_t >( _nodes.size() - 1 );
+    const auto labelBase = static_cast< uint32_t >( _labels.size() );
+    _labels.append( other._labels );
+    const uint32_t slotBase[] = { 0, _node4.append( other._node4 ),
+      _node16.append( other._node16 ), _node48.append( other._node48 ),
+      _node256.append( other._node256 ) };
+
+    _nodes.insert( _nodes.end(), other._nodes.begin() + 1, other._nodes.end() );
+    for ( size_t i = base + 1; i < _nodes.size(); ++i )
+    {
+      TrieNode_t& node = _nodes[ i ];
+      if ( node._labelLength > 1 )
+        node._labelBegin += labelBase;
+      if ( node._childKind != ChildKind_t::None )
+      {
+        node._children += slotBase[ static_cast< size_t >( node._childKind ) ];
+        relocateChildren( node, base );
+      }
+    }
+
+    // the copied container of the other root is not needed
+    const TrieNode_t& otherRoot = other._nodes[ 0 ];
+    const uint32_t rootSlot = otherRoot._children
+      + slotBase[ static_cast< size_t >( otherRoot._childKind ) ];
+    switch ( otherRoot._childKind )
+    {
+      case ChildKind_t::None: break;
+      case ChildKind_t::Node4: _node4.release( rootSlot ); break;
+      case ChildKind_t::Node16: _node16.release( rootSlot ); break;
+      case ChildKind_t::Node48: _node48.release( rootSlot ); break;
+      case ChildKind_t::Node256: _node256.release( rootSlot ); break;
+    }
+    other.forEachChild( other.root(), [ & ]( NodeIndex_t child )
+    {
+      insertChild( root(), static_cast< uint8_t >( _nodes[ base + child ]._letter ), base + child );
+    } );
+
+    TrieNode_t& ourRoot = _nodes[ 0 ];
+    ourRoot._wordCount += otherRoot._wordCount;
+    ourRoot._maxWeight = std::max( ourRoot._maxWeight, otherRoot._maxWeight );
+    if ( otherRoot._isLeaf )
+    {
+      ourRoot._isLeaf = true;
+      ourRoot._weight = std::max( ourRoot._weight, otherRoot._weight );
+    }
+  }
+
+private:
+  // one vector per container type, released slots are reused first
+  template< class T >
+  struct Pool_t
+  {
+    const T& operator[]( uint32_t slot ) const { return _slots[ slot ]; }
+    T& operator[]( uint32_t slot ) { return _slots[ slot ]; }
+
+    uint32_t allocate()
+    {
+      if ( !_free.empty() )
+      {
+        const uint32_t slot = _free.back();
+        _free.pop_back();
+        return slot;
+      }
+      _slots.emplace_back();
+      return static_cast< uint32_t >( _slots.size() - 1 );
+    }
+
+    void release( uint32_t slot ) { _free.push_back( slot ); }
+
+    // appends the slots of 'other', returns the slot its first one got
+    uint32_t append( const Pool_t& other )
+    {
+      const auto offset = static_cast< uint32_t >( _slots.size() );
+      _slots.insert( _slots.end(), other._slots.begin(), other._slots.end() );
+      for ( const uint32_t slot : other._free )
+        _free.push_back( slot + offset );
+      return offset;
+    }
+
+    size_t memoryUsage() const
+    {
+      return _slots.capacity() * sizeof( T ) + _free.capacity() * sizeof( uint32_t );
+    }
+
+    std::vector< T > _slots;
+    std::vector< uint32_t > _free;
+  };
+
+  // slot of 'key' among the first 'count' keys, or -1
+  template< size_t N >
+  static int findKey( const uint8_t ( &keys )[ N ], size_t count, uint8_t key )
+  {
+#if defined( __SSE2__ )
+    __m128i packed;
+    if constexpr ( N == 16 )
+    {
+      packed = _mm_loadu_si128( reinterpret_cast< const __m128i* >( keys ) );
+    }
+    else
+    {
+      int32_t word;
+      std::memcpy( &word, keys, sizeof( word ) );
+      packed = _mm_cvtsi32_si128( word );
+    }
+    const __m128i equal =
+      _mm_cmpeq_epi8( packed, _mm_set1_epi8( static_cast< char >( key ) ) );
+    const int mask = _mm_movemask_epi8( equal ) & ( ( 1 << count ) - 1 );
+    return mask ? __builtin_ctz( mask ) : -1;
+#else
+    for ( size_t i = 0; i < count; ++i )
+      if ( keys[ i ] == key )
+        return static_cast< int >( i );
+    return -1;
+#endif
+  }
+
+  // inserts 'child' into the sorted key/child arrays of a Node4 or Node16
+  template< class T >
+  static void insertSorted( T& n, size_t count, uint8_t key, NodeIndex_t child )
+  {
+    size_t pos = count;
+    while ( pos > 0 && n._keys[ pos - 1 ] > key )
+    {
+      n._keys[ pos ] = n._keys[ pos - 1 ];
+      n._children[ pos ] = n._children[ pos - 1 ];
+      --pos;
+    }
+    n._keys[ pos ] = key;
+    n._children[ pos ] = child;
+  }
+
+  void insertChild( NodeIndex_t parent, uint8_t key, NodeIndex_t child )
+  {
+    TrieNode_t& node = _nodes[ parent ];
+    switch ( node._childKind )
+    {
+      case ChildKind_t::None:
+        node._children = _node4.allocate();
+        node._childKind = ChildKind_t::Node4;
+        [[fallthrough]];
+      case ChildKind_t::Node4:
+        if ( node._childCount < 4 )
+        {
+          insertSorted( _node4[ node._children ], node._childCount, key, child );
+          break;
+        }
+        growToNode16( node );
+        [[fallthrough]];
+      case ChildKind_t::Node16:
+        if ( node._childCount < 16 )
+        {
+          insertSorted( _node16[ node._children ], node._childCount, key, child );
+          break;
+        }
+        growToNode48( node );
+        [[fallthrough]];
+      case ChildKind_t::Node48:
+        if ( node._childCount < 48 )
+        {
+          Node48_t& n = _node48[ node._children ];
+          n._children[ node._childCount ] = child;
+          n._index[ key ] = static_cast< uint8_t >( node._childCount + 1 );
+          break;
+        }
+        growToNode256( node );
+        [[fallthrough]];
+      case ChildKind_t::Node256:
+        _node256[ node._children ]._children[ key ] = child;
+        break;
+    }
+    ++node._childCount;
+  }
+
+  // adds 'base' to every child index in the container of 'node'
+  void relocateChildren( const TrieNode_t& node, NodeIndex_t base )
+  {
+    switch ( node._childKind )
+    {
+      case ChildKind_t::None:
+        break;
+      case ChildKind_t::Node4:
+        for ( size_t i = 0; i < node._childCount; ++i )
+          _node4[ node._children ]._children[ i ] += base;
+        break;
+      case ChildKind_t::Node16:
+        for ( size_t i = 0; i < node._childCount; ++i )
+          _node16[ node._children ]._children[ i ] += base;
+        break;
+      case ChildKind_t::Node48:
+        for ( size_t i = 0; i < node._childCount; ++i )
+          _node48[ node._children ]._children[ i ] += base;
+        break;
+      case ChildKind_t::Node256:
+        for ( NodeIndex_t& child : _node256[ node._children ]._children )
+          if ( child != kNullNode )
+            child += base;
+        break;
+    }
+  }
+
+  void growToNode16( TrieNode_t& node )
+  {
+    const uint32_t slot = _node16.allocate();
+    const Node4_t& from = _node4[ node._children ];
+    Node16_t& to = _node16[ slot ];
+    std::memcpy( to._keys, from._keys, sizeof( from._keys ) );
+    std::memcpy( to._children, from._children, sizeof( from._children ) );
+    _node4.release( node._children );
+    node._children = slot;
+    node._childKind = ChildKind_t::Node16;
+  }
+
+  void growToNode48( TrieNode_t& node )
+  {
+    const uint32_t slot = _node48.allocate();
+    const Node16_t& from = _node16[ node._children ];
+    Node48_t& to = _node48[ slot ];
+    std::memset( to._index, 0, sizeof( to._index ) );
+    for ( uint8_t i = 0; i < 16; ++i )
+    {
+      to._children[ i ] = from._children[ i ];
+      to._index[ from._keys[ i ] ] = static_cast< uint8_t >( i + 1 );
+    }
+    _node16.release( node._children );
+    node._children = slot;
+    node._childKind = ChildKind_t::Node48;
+  }
+
+  void growToNode256( TrieNode_t& node )
+  {
+    const uint32_t slot = _node256.allocate();
+    const Node48_t& from = _node48[ node._children ];
+    Node256_t& to = _node256[ slot ];
+    for ( size_t key = 0; key < 256; ++key )
+      to._children[ key ] = from._index[ key ]
+        ? from._children[ from._index[ key ] - 1 ] : kNullNode;
+    _node48.release( node._children );
+    node._children = slot;
+    node._childKind = ChildKind_t::Node256;
+  }
+
+  NodeIndex_t allocate()
+  {
+    if ( _nodes.size() >= kNullNode )
+      throw std::length_error( "NodeArena_c: node index space exhausted" );
+    _nodes.emplace_back();
+    return static_cast< NodeIndex_t >( _nodes.size() - 1 );
+  }
+
+  std::vector< TrieNode_t > _nodes;
+  std::string _labels;
+  Pool_t< Node4_t > _node4;
+  Pool_t< Node16_t > _node16;
+  Pool_t< Node48_t > _node48;
+  Pool_t< Node256_t > _node256;
+};
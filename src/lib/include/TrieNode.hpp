@@ -1,21 +1,59 @@
 #pragma once
 
-#include <unordered_map>
+#include <cstdint>
+#include <limits>
+
+// Nodes live in a NodeArena_c and refer to each other by 32-bit index.
+using NodeIndex_t = uint32_t;
+constexpr NodeIndex_t kNullNode = std::numeric_limits< NodeIndex_t >::max();
+
+// Child containers grow with the fanout of a node, as in adaptive radix trees.
+enum class ChildKind_t : uint8_t { None, Node4, Node16, Node48, Node256 };
 
 struct TrieNode_t
 {
-  TrieNode_t() : _isLeaf( false ){}
-  TrieNode_t( const TrieNode_t& ) = delete;
-
-  ~TrieNode_t()
-  {
-    for ( auto &item : _children )
-    {
-      if ( item.second )
-        delete item.second;
-    }
-  }
-
-  bool _isLeaf;
-  std::unordered_map< char, TrieNode_t* > _children;
-};
\ No newline at end of file
+  // edge label leading into this node. _letter is its first byte and the key
+  // used for child lookup. Labels longer than one byte (radix layout) live in
+  // the arena's label pool at [_labelBegin, _labelBegin + _labelLength).
+  uint32_t _labelBegin = 0;
+  uint32_t _labelLength = 0;
+  // slot of the child container in the arena pool selected by _childKind
+  uint32_t _children = kNullNode;
+  // number of words ending in the subtree rooted here, this node included
+  uint32_t _wordCount = 0;
+  // weight of the word ending here (if _isLeaf) and the largest weight of
+  // any word in the subtree, used to prune top-k searches
+  uint32_t _weight = 0;
+  uint32_t _maxWeight = 0;
+  uint16_t _childCount = 0;
+  ChildKind_t _childKind = ChildKind_t::None;
+  char _letter = '\0';
+  bool _isLeaf = false;
+};
+
+// up to 4 children, keys sorted ascending (as unsigned char)
+struct Node4_t
+{
+  uint8_t _keys[ 4 ];
+  NodeIndex_t _children[ 4 ];
+};
+
+// up to 16 children, keys sorted ascending and compared 16 at a time
+struct Node16_t
+{
+  uint8_t _keys[ 16 ];
+  NodeIndex_t _children[ 16 ];
+};
+
+// up to 48 children, _index[ key ] is the slot + 1 or 0 if there is no child
+struct Node48_t
+{
+  uint8_t _index[ 256 ];
+  NodeIndex_t _children[ 48 ];
+};
+
+// direct lookup by key
+struct Node256_t
+{
+  NodeIndex_t _children[ 256 ];
+};
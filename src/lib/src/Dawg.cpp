@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Dawg.hpp"
+
+DawgBuilder_c::DawgBuilder_c()
+{
+  newState();
+  _unchecked.push_back( 0 );
+}
+
+uint32_t DawgBuilder_c::newState()
+{
+  _states.emplace_back();
+  return static_cast< uint32_t >( _states.size() - 1 );
+}
+
+std::string DawgBuilder_c::signature( uint32_t state ) const
+{
+  const State_t& s = _states[ state ];
+  std::string key( 1, s._isFinal ? '1' : '0' );
+  for ( const auto& [ letter, target ] : s._edges )
+  {
+    key.push_back( letter );
+    key.append( reinterpret_cast< const char* >( &target ), sizeof( target ) );
+  }
+  return key;
+}
+
+/*!
+  Replaces every state on the unchecked path deeper than 'downTo' by an
+  equivalent registered state, or registers it. Children are handled before
+  their parents, so equivalence only needs to compare direct edges.
+  */
+void DawgBuilder_c::minimize( size_t downTo )
+{
+  while ( _unchecked.size() > downTo + 1 )
+  {
+    const uint32_t child = _unchecked.back();
+    _unchecked.pop_back();
+    const uint32_t parent = _unchecked.back();
+
+    const auto [ it, inserted ] = _register.emplace( signature( child ), child );
+    if ( !inserted )
+    {
+      // the child is the newest edge of its parent
+      _states[ parent ]._edges.back().second = it->second;
+      // and the newest state: its own children were all merged before it,
+      // a new registered child would have made it unique. Dropping it keeps
+      // the builder at the size of the DAWG plus the path of one word.
+      _states.pop_back();
+    }
+  }
+}
+
+void DawgBuilder_c::insertSorted( const std::string & word )
+{
+  if ( !_empty )
+  {
+    const int order = word.compare( _previous );
+    if ( order == 0 )
+      return;
+    if ( order < 0 )
+      throw std::invalid_argument( "DawgBuilder_c: input is not sorted" );
+  }
+
+  size_t common = 0;
+  while ( common < word.size() && common < _previous.size()
+          && word[ common ] == _previous[ common ] )
+    ++common;
+
+  minimize( common );
+
+  uint32_t state = _unchecked.back();
+  for ( size_t i = common; i < word.size(); ++i )
+  {
+    const uint32_t next = newState();
+    _states[ state ]._edges.emplace_back( word[ i ], next );
+    _unchecked.push_back( next );
+    state = next;
+  }
+  _states[ state ]._isFinal = true;
+
+  _previous = word;
+  _empty = false;
+}
+
+std::unique_ptr< Dawg_c > DawgBuilder_c::finish()
+{
+  minimize( 0 );
+
+  auto dawg = std::unique_ptr< Dawg_c >( new Dawg_c() );
+
+  // renumber the reachable states in depth-first order
+  std::vector< uint32_t > newId( _states.size(), Dawg_c::kNoState );
+  std::vector< uint32_t > order;
+  std::vector< uint32_t > stack{ 0 };
+  while ( !stack.empty() )
+  {
+    const uint32_t state = stack.back();
+    stack.pop_back();
+    if ( newId[ state ] != Dawg_c::kNoState )
+      continue;
+    newId[ state ] = static_cast< uint32_t >( order.size() );
+    order.push_back( state );
+    const auto& edges = _states[ state ]._edges;
+    for ( auto it = edges.rbegin(); it != edges.rend(); ++it )
+      if ( newId[ it->second ] == Dawg_c::kNoState )
+        stack.push_back( it->second );
+  }
+
+  dawg->_firstEdge.reserve( order.size() + 1 );
+  for ( const uint32_t state : order )
+  {
+    dawg->_firstEdge.push_back( static_cast< uint32_t >( dawg->_edgeTargets.size() ) );
+    dawg->_final.push_back( _states[ state ]._isFinal );
+    for ( const auto& [ letter, target ] : _states[ state ]._edges )
+    {
+      dawg->_edgeLabels.push_back( letter );
+      dawg->_edgeTargets.push_back( newId[ target ] );
+    }
+  }
+  dawg->_firstEdge.push_back( static_cast< uint32_t >( dawg->_edgeTargets.size() ) );
+  dawg->_final.build();
+  dawg->_wordCounts.assign( order.size(), Dawg_c::kNoState );
+  dawg->countWords( 0 );
+
+  // the builder is spent, start over
+  *this = DawgBuilder_c();
+  return dawg;
+}
+
+uint32_t Dawg_c::findChild( uint32_t state, char letter ) const
+{
+  const auto key = static_cast< unsigned char >( letter );
+  for ( uint32_t edge = _firstEdge[ state ]; edge < _firstEdge[ state + 1 ]; ++edge )
+  {
+    const auto edgeKey = static_cast< unsigned char >( _edgeLabels[ edge ] );
+    if ( edgeKey == key )
+      return _edgeTargets[ edge ];
+    if ( edgeKey > key )
+      break;
+  }
+  return kNoState;
+}
+
+uint32_t Dawg_c::descend( const std::string& prefix ) const
+{
+  uint32_t state = 0;
+  for ( const char letter : prefix )
+  {
+    state = findChild( state, letter );
+    if ( state == kNoState )
+      break;
+  }
+  return state;
+}
+
+void Dawg_c::collect( uint32_t state, std::string& path,
+    std::vector< std::string >& out ) const
+{
+  if ( _final[ state ] )
+    out.push_back( path );
+
+  for ( uint32_t edge = _firstEdge[ state ]; edge < _firstEdge[ state + 1 ]; ++edge )
+  {
+    path.push_back( _edgeLabels[ edge ] );
+    collect( _edgeTargets[ edge ], path, out );
+    path.pop_back();
+  }
+}
+
+/*!
+  Appends the words accepted from 'state' (reached by 'path') to 'out' until
+  it holds 'limit' words, leaving out the first 'skip'. Subgraphs that lie
+  completely in front of the page are skipped by their word count.
+  */
+void Dawg_c::collectPage( uint32_t state, std::string& path, size_t& skip, size_t limit,
+    std::vector< std::string >& out ) const
+{
+  if ( out.size() >= limit )
+    return;
+  if ( skip >= _wordCounts[ state ] )
+  {
+    skip -= _wordCounts[ state ];
+    return;
+  }
+
+  if ( _final[ state ] )
+  {
+    if ( skip > 0 )
+      --skip;
+    else
+      out.push_back( path );
+  }
+
+  for ( uint32_t edge = _firstEdge[ state ]; edge < _firstEdge[ state + 1 ] && out.size() < limit; ++edge )
+  {
+    path.push_back( _edgeLabels[ edge ] );
+    collectPage( _edgeTargets[ edge ], path, skip, limit, out );
+    path.pop_back();
+  }
+}
+
+uint32_t Dawg_c::countWords( uint32_t state )
+{
+  // shared states are counted once
+  if ( _wordCounts[ state ] != kNoState )
+    return _wordCounts[ state ];
+
+  uint32_t count = _final[ state ];
+  for ( uint32_t edge = _firstEdge[ state ]; edge < _firstEdge[ state + 1 ]; ++edge )
+    count += countWords( _edgeTargets[ edge ] );
+  _wordCounts[ state ] = count;
+  return count;
+}
+
+bool Dawg_c::containsPrefix( const std::string& prefix ) const
+{
+  const uint32_t state = descend( prefix );
+  if ( state == kNoState )
+    return false;
+  // every state but the root of an empty DAWG leads to a word
+  return state != 0 || !_edgeTargets.empty() || _final[ 0 ];
+}
+
+void Dawg_c::findPrefixMatches( const std::string& prefix,
+    std::vector< std::string >& out ) const
+{
+  const uint32_t state = descend( prefix );
+  if ( state == kNoState )
+    return;
+
+  std::string path = prefix;
+  collect( state, path, out );
+}
+
+size_t Dawg_c::countPrefixMatches( const std::string& prefix ) const
+{
+  const uint32_t state = descend( prefix );
+  return state == kNoState ? 0 : _wordCounts[ state ];
+}
+
+bool Dawg_c::findPage( const std::string& prefix, size_t skip, size_t limit,
+    std::vector< std::string >& out ) const
+{
+  const uint32_t state = descend( prefix );
+  if ( state == kNoState )
+    return false;
+
+  const size_t before = out.size();
+  std::string path = prefix;
+  size_t toSkip = skip;
+  collectPage( state, path, toSkip, pageEnd( before, limit ), out );
+  return skip + ( out.size() - before ) < _wordCounts[ state ];
+}
+
+size_t Dawg_c::countUpTo( const std::string& prefix, const std::string& last ) const
+{
+  uint32_t state = descend( prefix );
+  if ( state == kNoState )
+    return 0;
+  const int place = placeLast( prefix, last );
+  if ( place != 0 )
+    return place > 0 ? _wordCounts[ state ] : 0;
+
+  size_t count = 0;
+  for ( size_t depth = prefix.size(); ; ++depth )
+  {
+    // the word spelled here is a prefix of 'last', or 'last' itself
+    if ( _final[ state ] )
+      ++count;
+    if ( depth == last.size() )
+      return count;
+
+    const auto key = static_cast< unsigned char >( last[ depth ] );
+    uint32_t next = kNoState;
+    for ( uint32_t edge = _firstEdge[ state ]; edge < _firstEdge[ state + 1 ]; ++edge )
+    {
+      const auto edgeKey = static_cast< unsigned char >( _edgeLabels[ edge ] );
+      if ( edgeKey < key )
+        count += _wordCounts[ _edgeTargets[ edge ] ];
+      else
+      {
+        if ( edgeKey == key )
+          next = _edgeTargets[ edge ];
+        break;
+      }
+    }
+    if ( next == kNoState )
+      return count;
+    state = next;
+  }
+}
+
+size_t Dawg_c::memoryUsage() const
+{
+  return sizeof( *this ) + _firstEdge.capacity() * sizeof( uint32_t )
+    + _edgeLabels.capacity() + _edgeTargets.capacity() * sizeof( uint32_t )
+    + _final.memoryUsage() + _wordCounts.capacity() * sizeof( uint32_t );
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "FrozenTrie.hpp"
+#include "include/BitVector.hpp"
+
+/*!
+  Minimal acyclic word graph (DAWG): a trie in which equal subtrees, and so
+  shared suffixes such as "-ing" or "-ness", are stored only once.
+  Built by DawgBuilder_c. States are numbered in depth-first order and their
+  outgoing edges are stored contiguously, sorted by byte.
+  */
+class Dawg_c : public FrozenTrie_c
+{
+public:
+  bool containsPrefix( const std::string& prefix ) const override;
+  void findPrefixMatches( const std::string& prefix,
+      std::vector< std::string >& out ) const override;
+  size_t countPrefixMatches( const std::string& prefix ) const override;
+  bool findPage( const std::string& prefix, size_t skip, size_t limit,
+      std::vector< std::string >& out ) const override;
+  size_t countUpTo( const std::string& prefix, const std::string& last ) const override;
+
+  size_t memoryUsage() const override;
+
+  size_t nodeCount() const { return _firstEdge.size() - 1; }
+  size_t edgeCount() const { return _edgeTargets.size(); }
+
+private:
+  friend class DawgBuilder_c;
+
+  static constexpr uint32_t kNoState = UINT32_MAX;
+
+  uint32_t findChild( uint32_t state, char letter ) const;
+  uint32_t descend( const std::string& prefix ) const;
+  void collect( uint32_t state, std::string& path,
+      std::vector< std::string >& out ) const;
+  void collectPage( uint32_t state, std::string& path, size_t& skip, size_t limit,
+      std::vector< std::string >& out ) const;
+  // fills _wordCounts for 'state' and everything below it
+  uint32_t countWords( uint32_t state );
+
+  // edges of state s are [ _firstEdge[ s ], _firstEdge[ s + 1 ] )
+  std::vector< uint32_t > _firstEdge;
+  std::string _edgeLabels;
+  std::vector< uint32_t > _edgeTargets;
+  BitVector_c _final;
+  // number of words accepted from state s, the same on every path to s
+  std::vector< uint32_t > _wordCounts;
+};
+
+/*!
+  Incremental construction of a minimal DAWG from lexicographically sorted
+  input in a single pass (Daciuk et al., 2000). Only the path of the most
+  recent word is still mutable; everything left of it is minimized against a
+  register of already unique states as soon as the next word diverges.
+  */
+class DawgBuilder_c
+{
+public:
+  DawgBuilder_c();
+
+  // words must arrive in ascending order, duplicates are ignored.
+  // Throws std::invalid_argument on unsorted input.
+  void insertSorted( const std::string& word );
+
+  std::unique_ptr< Dawg_c > finish();
+
+private:
+  struct State_t
+  {
+    bool _isFinal = false;
+    std::vector< std::pair< char, uint32_t > > _edges;
+  };
+
+  uint32_t newState();
+  void minimize( size_t downTo );
+  std::string signature( uint32_t state ) const;
+
+  std::vector< State_t > _states;
+  // edges on the path of the previous word that are not minimized yet
+  std::vector< uint32_t > _unchecked;
+  std::unordered_map< std::string, uint32_t > _register;
+  std::string _previous;
+  bool _empty = true;
+};
@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "DeletionIndex.hpp"
+
+namespace
+{
+  uint64_t fnv1a( std::string_view text )
+  {
+    uint64_t hash = 14695981039346656037ull;
+    for ( const char c : text )
+    {
+      hash ^= static_cast< unsigned char >( c );
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  // all strings made by deleting up to 'distance' bytes of 'text', 'text'
+  // itself included, without duplicates
+  void deletions( std::string_view text, uint32_t distance, std::vector< std::string >& out )
+  {
+    out.assign( 1, std::string( text ) );
+    size_t levelBegin = 0;
+    for ( uint32_t d = 0; d < distance; ++d )
+    {
+      const size_t levelEnd = out.size();
+      for ( size_t v = levelBegin; v < levelEnd; ++v )
+        for ( size_t i = 0; i < out[ v ].size(); ++i )
+        {
+          std::string shorter = out[ v ];
+          shorter.erase( i, 1 );
+          out.push_back( std::move( shorter ) );
+        }
+      levelBegin = levelEnd;
+    }
+    std::sort( out.begin(), out.end() );
+    out.erase( std::unique( out.begin(), out.end() ), out.end() );
+  }
+
+  uint32_t editDistance( std::string_view a, std::string_view b, std::vector< uint32_t >& row )
+  {
+    row.resize( b.size() + 1 );
+    for ( size_t j = 0; j <= b.size(); ++j )
+      row[ j ] = static_cast< uint32_t >( j );
+    for ( size_t i = 1; i <= a.size(); ++i )
+    {
+      uint32_t diagonal = row[ 0 ];
+      row[ 0 ] = static_cast< uint32_t >( i );
+      for ( size_t j = 1; j <= b.size(); ++j )
+      {
+        const uint32_t above = row[ j ];
+        row[ j ] = std::min( { above + 1, row[ j - 1 ] + 1, diagonal + ( a[ i - 1 ] != b[ j - 1 ] ) } );
+        diagonal = above;
+      }
+    }
+    return row[ b.size() ];
+  }
+}
+
+DeletionIndex_c::DeletionIndex_c( std::vector< std::string_view > words,
+    const DeletionIndexConfig_t & config, std::shared_ptr< const void > owner ) :
+  _maxDistance( std::min< uint32_t >( config._maxDistance, 2 ) ),
+  _words( std::move( words ) ),
+  _owner( std::move( owner ) )
+{
+  if ( _words.size() >= std::numeric_limits< uint32_t >::max() )
+    throw std::length_error( "DeletionIndex_c: too many words" );
+  _words.shrink_to_fit();
+
+  // the first id of every distinct word, repeats are not indexed
+  std::vector< uint32_t > distinct( _words.size() );
+  std::iota( distinct.begin(), distinct.end(), 0 );
+  std::sort( distinct.begin(), distinct.end(), [ this ]( uint32_t a, uint32_t b )
+  {
+    return _words[ a ] != _words[ b ] ? _words[ a ] < _words[ b ] : a < b;
+  } );
+  distinct.erase( std::unique( distinct.begin(), distinct.end(),
+      [ this ]( uint32_t a, uint32_t b ) { return _words[ a ] == _words[ b ]; } ), distinct.end() );
+
+  // fewer deletions until the index fits
+  while ( !build( distinct, config._memoryBudget ) )
+  {
+    if ( _maxDistance == 0 )
+      throw std::length_error( "DeletionIndex_c: dictionary exceeds the memory budget" );
+    --_maxDistance;
+  }
+}
+
+/*!
+  Generates the variants of the 'distinct' words for _maxDistance and lays
+  out the lookup structures. Checks the peak memory of the build against
+  'budget' before allocating anything: the number of (variant, word) pairs
+  is bounded by the deletion count of every word, and each pair costs at
+  most 32 bytes at a time. While sorting it is a padded 16-byte std::pair,
+  next to which the 4-byte id, 8-byte key and 4-byte offset it turns into
+  are filled; once the pairs are freed, the table takes at most 16 bytes
+  per key.
+  */
+bool DeletionIndex_c::build( const std::vector< uint32_t > & distinct, size_t budget )
+{
+  using Pair_t = std::pair< uint64_t, uint32_t >;
+  constexpr size_t kPairBytes = sizeof( Pair_t ) + 2 * sizeof( uint32_t ) + sizeof( uint64_t );
+  // the table never has fewer than 16 slots
+  const size_t fixed = _words.capacity() * sizeof( std::string_view )
+    + distinct.capacity() * sizeof( uint32_t ) + 16 * sizeof( uint32_t );
+
+  size_t maxPairs = 0;
+  for ( const uint32_t id : distinct )
+  {
+    const size_t length = std::min( _words[ id ].size(), kPrefixLength );
+    // C( length, 0 ) + C( length, 1 ) + C( length, 2 ), as far as asked for
+    maxPairs += 1 + ( _maxDistance >= 1 ? length : 0 )
+      + ( _maxDistance >= 2 && length > 1 ? length * ( length - 1 ) / 2 : 0 );
+  }
+  if ( fixed + maxPairs * kPairBytes > budget )
+    return false;
+
+  std::vector< Pair_t > pairs;
+  pairs.reserve( maxPairs );
+  std::vector< std::string > variants;
+  for ( const uint32_t id : distinct )
+  {
+    deletions( _words[ id ].substr( 0, kPrefixLength ), _maxDistance, variants );
+    for ( const auto& variant : variants )
+      pairs.emplace_back( fnv1a( variant ), id );
+  }
+
+  std::sort( pairs.begin(), pairs.end() );
+  pairs.erase( std::unique( pairs.begin(), pairs.end() ), pairs.end() );
+  size_t numKeys = 0;
+  for ( size_t i = 0; i < pairs.size(); ++i )
+    numKeys += i == 0 || pairs[ i ].first != pairs[ i - 1 ].first;
+
+  _keys.clear();
+  _idBegin.clear();
+  _ids.clear();
+  _keys.reserve( numKeys );
+  _idBegin.reserve( numKeys + 1 );
+  _ids.reserve( pairs.size() );
+  for ( const auto& [ hash, id ] : pairs )
+  {
+    if ( _keys.empty() || _keys.back() != hash )
+    {
+      _keys.push_back( hash );
+      _idBegin.push_back( static_cast< uint32_t >( _ids.size() ) );
+    }
+    _ids.push_back( id );
+  }
+  _idBegin.push_back( static_cast< uint32_t >( _ids.size() ) );
+  std::vector< Pair_t >().swap( pairs );
+
+  // at most half full
+  size_t capacity = 16;
+  while ( capacity < 2 * _keys.size() )
+    capacity *= 2;
+  _table.assign( capacity, 0 );
+  for ( size_t k = 0; k < _keys.size(); ++k )
+  {
+    size_t slot = _keys[ k ] & ( capacity - 1 );
+    while ( _table[ slot ] )
+      slot = ( slot + 1 ) & ( capacity - 1 );
+    _table[ slot ] = static_cast< uint32_t >( k + 1 );
+  }
+  return true;
+}
+
+size_t DeletionIndex_c::find( uint64_t hash ) const
+{
+  const size_t mask = _table.size() - 1;
+  for ( size_t slot = hash & mask; _table[ slot ]; slot = ( slot + 1 ) & mask )
+    if ( _keys[ _table[ slot ] - 1 ] == hash )
+      return _table[ slot ] - 1;
+  return _keys.size();
+}
+
+std::vector< Suggestion_t > DeletionIndex_c::lookup( std::string_view query, uint32_t maxEdits ) const
+{
+  maxEdits = std::min( maxEdits, _maxDistance );
+
+  std::vector< std::string > variants;
+  deletions( query.substr( 0, kPrefixLength ), maxEdits, variants );
+
+  std::vector< uint32_t > candidates;
+  for ( const auto& variant : variants )
+  {
+    const size_t k = find( fnv1a( variant ) );
+    if ( k < _keys.size() )
+      candidates.insert( candidates.end(), _ids.begin() + _idBegin[ k ], _ids.begin() + _idBegin[ k + 1 ] );
+  }
+  std::sort( candidates.begin(), candidates.end() );
+  candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+
+  std::vector< Suggestion_t > suggestions;
+  std::vector< uint32_t > row;
+  for ( const uint32_t id : candidates )
+  {
+    const std::string_view candidate = word( id );
+    // the lengths alone may rule it out
+    const size_t lengthGap = candidate.size() > query.size()
+      ? candidate.size() - query.size() : query.size() - candidate.size();
+    if ( lengthGap > maxEdits )
+      continue;
+    const uint32_t distance = editDistance( query, candidate, row );
+    if ( distance <= maxEdits )
+      suggestions.push_back( { id, candidate, distance } );
+  }
+
+  std::sort( suggestions.begin(), suggestions.end(),
+      []( const Suggestion_t& a, const Suggestion_t& b )
+      {
+        return a._distance != b._distance ? a._distance < b._distance : a._word < b._word;
+      } );
+  return suggestions;
+}
+
+size_t DeletionIndex_c::memoryUsage() const
+{
+  return _words.capacity() * sizeof( std::string_view )
+    + _keys.capacity() * sizeof( uint64_t ) + _idBegin.capacity() * sizeof( uint32_t )
+    + _ids.capacity() * sizeof( uint32_t ) + _table.capacity() * sizeof( uint32_t );
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct DeletionIndexConfig_t
+{
+  // largest edit distance lookups can be asked for, at most 2
+  uint32_t _maxDistance = 2;
+  // upper bound for the memory held while building, and so for
+  // memoryUsage(); the distance is lowered until it fits
+  size_t _memoryBudget = size_t( 256 ) << 20;
+};
+
+struct Suggestion_t
+{
+  // position of the word in the input of DeletionIndex_c
+  uint32_t _id;
+  std::string_view _word;
+  uint32_t _distance;
+};
+
+/*!
+  Symmetric delete spelling correction (SymSpell). Every dictionary word is
+  indexed under all strings that result from deleting up to _maxDistance
+  bytes of its first kPrefixLength bytes. A lookup generates the same
+  deletions of the query, probes a hash table for each and verifies the
+  candidates it finds by their real edit distance, so it never walks the
+  trie. Variants are stored as 64-bit hashes only, collisions merely add
+  candidates that fail verification.
+  The words are not copied: the index keeps views into the caller's text,
+  and a word's id is its position in the input, e.g. the loader's line
+  number. A word given more than once is found under its first id.
+  The index is immutable after construction and can be shared between
+  threads, e.g. through std::shared_ptr< const DeletionIndex_c >.
+  */
+class DeletionIndex_c
+{
+public:
+  // 'owner' keeps the characters of 'words' alive, e.g. the mapped file
+  // they were read from; without one the caller has to outlive the index.
+  // Throws std::length_error if not even distance 0 fits the memory budget.
+  DeletionIndex_c( std::vector< std::string_view > words,
+      const DeletionIndexConfig_t& config = DeletionIndexConfig_t(),
+      std::shared_ptr< const void > owner = nullptr );
+  DeletionIndex_c( const DeletionIndex_c& ) = delete;
+
+  /*!
+    Dictionary words within 'maxEdits' insertions, deletions or
+    substitutions of 'word', nearest first, then in lexicographic order.
+    'maxEdits' is capped at maxDistance().
+    */
+  std::vector< Suggestion_t > lookup( std::string_view word, uint32_t maxEdits ) const;
+
+  // the distance the index was built for, may be below the requested one
+  uint32_t maxDistance() const { return _maxDistance; }
+  size_t wordCount() const { return _words.size(); }
+  std::string_view word( uint32_t id ) const { return _words[ id ]; }
+  // the index alone, without the text its words point into
+  size_t memoryUsage() const;
+
+private:
+  // longer words are indexed by the deletions of their first bytes only
+  static constexpr size_t kPrefixLength = 7;
+
+  bool build( const std::vector< uint32_t >& distinct, size_t budget );
+  // index of 'hash' in _keys, or _keys.size()
+  size_t find( uint64_t hash ) const;
+
+  uint32_t _maxDistance;
+  // word i of the input, owned by _owner or the caller
+  std::vector< std::string_view > _words;
+  std::shared_ptr< const void > _owner;
+  // distinct variant hashes, the words of _keys[ k ] are
+  // _ids[ _idBegin[ k ] .. _idBegin[ k + 1 ] )
+  std::vector< uint64_t > _keys;
+  std::vector< uint32_t > _idBegin;
+  std::vector< uint32_t > _ids;
+  // open addressing over _keys, 0 is empty, otherwise key index + 1
+  std::vector< uint32_t > _table;
+};
@@ -1,30 +1,123 @@
-#include <iostream>
-#include <fstream>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "Dictionary.hpp"
+#include "MappedFile.hpp"
+
+namespace
+{
+  // one word per line, an optional weight behind a tab: "word\t42".
+  // A weight that is not a number in range counts as 1, like a missing one.
+  // CRLF line endings are accepted.
+  void scanLines( std::string_view chunk, std::vector< WordEntry_t >& words )
+  {
+    while ( !chunk.empty() )
+    {
+      const size_t end = chunk.find( '\n' );
+      std::string_view line = chunk.substr( 0, end );
+      chunk.remove_prefix( end == std::string_view::npos ? chunk.size() : end + 1 );
+      if ( !line.empty() && line.back() == '\r' )
+        line.remove_suffix( 1 );
+
+      uint32_t weight = 1;
+      const size_t tab = line.find( '\t' );
+      if ( tab != std::string_view::npos )
+      {
+        const char* const last = line.data() + line.size();
+        uint32_t parsed = 0;
+        const auto [ stop, error ] = std::from_chars( line.data() + tab + 1, last, parsed );
+        if ( error == std::errc() && stop == last )
+          weight = parsed;
+        line = line.substr( 0, tab );
+      }
+      words.push_back( { line, weight } );
+    }
+  }
+}
 
 Dictionary_c::Dictionary_c()
 {
-  _trie = std::make_unique< Trie_c >( 4 );
+  _trie = std::make_unique< Trie_c >( std::max( 1u, std::thread::hardware_concurrency() ) );
 }
 
 Dictionary_c::~Dictionary_c() = default;
 
-void Dictionary_c::initDictionary( const std::string &filePath )
+/*!
+  Maps the file and scans it in newline-aligned chunks, one per worker of
+  the trie, on the trie's pool. The words are views into the mapping, the
+  only copy of their characters is the one the trie makes.
+  */
+LoadStats_t Dictionary_c::initDictionary( const std::string &filePath,
+    const std::optional< DeletionIndexConfig_t > &corrections )
 {
-  std::ifstream myFile( filePath.c_str() );
-  //myFile.open( filePath, std::ios::in );
+  // shared with the spelling correction, which points into it
+  const auto file = std::make_shared< const MappedFile_c >( filePath );
 
-  if ( myFile.is_open() )
+  const auto start = std::chrono::steady_clock::now();
+  const std::string_view text( file->data(), file->size() );
+
+  // chunk i starts behind the first newline at or after i / numChunks of
+  // the file
+  const size_t numChunks = std::max< size_t >( 1, _trie->_numWorkers );
+  std::vector< size_t > bounds( numChunks + 1, 0 );
+  bounds[ numChunks ] = text.size();
+  for ( size_t i = 1; i < numChunks; ++i )
   {
-    std::string line;
-    while ( std::getline( myFile, line ) )
+    const size_t newline = text.find( '\n', std::max( bounds[ i - 1 ], text.size() * i / numChunks ) );
+    bounds[ i ] = newline == std::string_view::npos ? text.size() : newline + 1;
+  }
+
+  std::vector< std::vector< WordEntry_t > > chunkWords( numChunks );
+  const auto scanChunk = [ & ]( size_t i )
+  {
+    scanLines( text.substr( bounds[ i ], bounds[ i + 1 ] - bounds[ i ] ), chunkWords[ i ] );
+  };
+  if ( _trie->_pool )
+    _trie->_pool->forEach( numChunks, scanChunk );
+  else
+    scanChunk( 0 );
+
+  std::vector< WordEntry_t > words = std::move( chunkWords[ 0 ] );
+  for ( size_t i = 1; i < numChunks; ++i )
+    words.insert( words.end(), chunkWords[ i ].begin(), chunkWords[ i ].end() );
+
+  // sorted files are built in one linear pass, anything else by building
+  // subtries in parallel on the trie's workers
+  const bool sorted = std::is_sorted( words.begin(), words.end(),
+      []( const WordEntry_t& a, const WordEntry_t& b ) { return a._word < b._word; } );
+  if ( sorted )
+    this->_trie->buildFromSorted( words );
+  else
+    this->_trie->insertWords( words );
+
+  if ( corrections )
+  {
+    std::vector< std::string_view > spellings;
+    spellings.reserve( words.size() );
+    for ( const auto& entry : words )
+      spellings.push_back( entry._word );
+    try
+    {
+      // suggestion ids are line numbers, the index keeps the mapping alive
+      this->_corrections = std::make_shared< const DeletionIndex_c >( std::move( spellings ),
+          *corrections, file );
+    }
+    catch ( const std::length_error& )
     {
-      this->_trie->insertWord( line );
+      // over budget: no spelling correction
     }
-    myFile.close();
   }
-  else std::cout << "Unable to open file";
+
+  const std::chrono::duration< double > seconds = std::chrono::steady_clock::now() - start;
+  return { words.size(), text.size(), seconds.count() };
 }
@@ -1,17 +1,36 @@
 #pragma once
 
 #include<memory>
+#include<optional>
 #include<string>
 
+#include "DeletionIndex.hpp"
 #include "Trie.hpp"
 
+// what initDictionary read, and how long it took
+struct LoadStats_t
+{
+  size_t _words = 0;
+  size_t _bytes = 0;
+  double _seconds = 0.0;
+};
+
 class Dictionary_c
 {
 public:
+  // the trie gets one worker per hardware thread
   Dictionary_c();
   ~Dictionary_c();
 
-  void initDictionary( const std::string& );
+  // Also builds _corrections when 'corrections' is given; it stays null if
+  // the index would exceed its memory budget. Throws std::runtime_error if
+  // the file cannot be opened.
+  LoadStats_t initDictionary( const std::string&,
+      const std::optional< DeletionIndexConfig_t >& corrections = std::nullopt );
 
   std::unique_ptr< Trie_c > _trie;
+  // spelling correction over the same words, null unless requested; may be
+  // handed to other threads and outlive the dictionary. Its word ids are the
+  // line numbers of the file.
+  std::shared_ptr< const DeletionIndex_c > _corrections;
 };
\ No newline at end of file
@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "DoubleArrayTrie.hpp"
+
+namespace
+{
+  constexpr uint8_t kMaxFailures = 16;
+
+  // a byte position in the arena: 'consumed' bytes of node's label are spelled
+  struct Position_t
+  {
+    NodeIndex_t _node;
+    uint32_t _consumed;
+    int32_t _unit;
+  };
+
+  /*!
+    Build-time bookkeeping of free units as a doubly linked list, so the
+    search for a new BASE only ever looks at free cells. A cell can leave the
+    list while still free (it failed too often), so removing tolerates cells
+    that are not linked any more.
+    */
+  class FreeList_c
+  {
+  public:
+    static constexpr int32_t kEnd = -1;
+    // _prev and _next of a cell that is not in the list
+    static constexpr int32_t kUnlinked = -2;
+
+    int32_t first() const { return _head; }
+    int32_t next( int32_t unit ) const { return _next[ unit ]; }
+
+    void grow( size_t newSize )
+    {
+      for ( size_t i = _next.size(); i < newSize; ++i )
+      {
+        const auto unit = static_cast< int32_t >( i );
+        _next.push_back( kEnd );
+        _prev.push_back( _tail );
+        if ( _tail == kEnd )
+          _head = unit;
+        else
+          _next[ _tail ] = unit;
+        _tail = unit;
+      }
+    }
+
+    void remove( int32_t unit )
+    {
+      const int32_t prev = _prev[ unit ];
+      const int32_t next = _next[ unit ];
+      if ( prev == kUnlinked )
+        return;
+      _prev[ unit ] = kUnlinked;
+      _next[ unit ] = kUnlinked;
+      if ( prev == kEnd )
+        _head = next;
+      else
+        _next[ prev ] = next;
+      if ( next == kEnd )
+        _tail = prev;
+      else
+        _prev[ next ] = prev;
+    }
+
+  private:
+    std::vector< int32_t > _next;
+    std::vector< int32_t > _prev;
+    int32_t _head = kEnd;
+    int32_t _tail = kEnd;
+  };
+}
+
+DoubleArrayTrie_c::DoubleArrayTrie_c( const NodeArena_c& arena )
+{
+  _storage.resize( 256 );
+  FreeList_c freeList;
+  freeList.grow( _storage.size() );
+  std::vector< uint8_t > failures( _storage.size() );
+  freeList.remove( 0 );
+  // the root is in use but has no parent
+  _storage[ 0 ]._check = -2;
+
+  std::deque< Position_t > queue;
+  queue.push_back( { arena.root(), 0, 0 } );
+  std::vector< std::pair< uint8_t, Position_t > > children;
+
+  while ( !queue.empty() )
+  {
+    const Position_t pos = queue.front();
+    queue.pop_front();
+
+    // a position inside a radix edge leads to the same words as its node
+    _storage[ pos._unit ]._wordCount = arena[ pos._node ]._wordCount;
+
+    // collect the outgoing bytes of this position, already in ascending order
+    children.clear();
+    const std::string_view label = arena.label( pos._node );
+    if ( pos._consumed < label.size() )
+    {
+      children.push_back( { static_cast< uint8_t >( label[ pos._consumed ] ),
+          { pos._node, pos._consumed + 1, 0 } } );
+    }
+    else
+    {
+      _storage[ pos._unit ]._isLeaf = arena[ pos._node ]._isLeaf;
+      arena.forEachChild( pos._node, [ & ]( NodeIndex_t child )
+      {
+        children.push_back( { static_cast< uint8_t >( arena[ child ]._letter ),
+            { child, 1, 0 } } );
+      } );
+    }
+    if ( children.empty() )
+      continue;
+
+    // first fit: anchor the smallest label on a free cell, test the others
+    int32_t base = 0;
+    for ( int32_t cell = freeList.first(); ; )
+    {
+      if ( cell == FreeList_c::kEnd )
+      {
+        // nothing fits, append fresh cells behind the array
+        cell = static_cast< int32_t >( _storage.size() );
+        _storage.resize( _storage.size() + 256 );
+        freeList.grow( _storage.size() );
+        failures.resize( _storage.size() );
+      }
+
+      base = cell - children.front().first;
+      const size_t last = static_cast< size_t >( std::max( base, 0 ) )
+        + children.back().first;
+      if ( last >= _storage.size() )
+      {
+        _storage.resize( last + 256 );
+        freeList.grow( _storage.size() );
+        failures.resize( _storage.size() );
+      }
+
+      bool fits = base >= 1;
+      for ( size_t i = 0; fits && i < children.size(); ++i )
+        fits = _storage[ base + children[ i ].first ]._check == -1;
+      if ( fits )
+        break;
+
+      // give up on cells that keep failing, they only slow down the search
+      const int32_t next = freeList.next( cell );
+      if ( ++failures[ cell ] >= kMaxFailures )
+        freeList.remove( cell );
+      cell = next;
+    }
+
+    DaUnit_t& parent = _storage[ pos._unit ];
+    parent._base = base;
+    parent._firstChild = children.front().first;
+    for ( size_t i = 0; i < children.size(); ++i )
+    {
+      const int32_t unit = base + children[ i ].first;
+      freeList.remove( unit );
+      _storage[ unit ]._check = pos._unit;
+      if ( i + 1 < children.size() )
+        _storage[ unit ]._nextSibling = children[ i + 1 ].first;
+
+      Position_t childPos = children[ i ].second;
+      childPos._unit = unit;
+      queue.push_back( childPos );
+    }
+  }
+
+  // trailing free cells are never reached
+  while ( _storage.size() > 1 && _storage.back()._check == -1 )
+    _storage.pop_back();
+  _storage.shrink_to_fit();
+  _units = _storage.data();
+  _unitCount = _storage.size();
+}
+
+DoubleArrayTrie_c::DoubleArrayTrie_c( const DaUnit_t* units, size_t unitCount ) :
+  _units( units ), _unitCount( unitCount )
+{
+}
+
+int32_t DoubleArrayTrie_c::descend( const std::string& prefix ) const
+{
+  int32_t unit = 0;
+  for ( const char letter : prefix )
+  {
+    const size_t next = static_cast< size_t >( _units[ unit ]._base )
+      + static_cast< unsigned char >( letter );
+    if ( next >= _unitCount || _units[ next ]._check != unit )
+      return -1;
+    unit = static_cast< int32_t >( next );
+  }
+  return unit;
+}
+
+void DoubleArrayTrie_c::collect( int32_t unit, std::string& path,
+    std::vector< std::string >& out ) const
+{
+  if ( _units[ unit ]._isLeaf )
+    out.push_back( path );
+
+  for ( uint16_t label = _units[ unit ]._firstChild; label < kNoLabel; )
+  {
+    // units may come from an image: a child that is out of range or does
+    // not name us as its parent ends the walk. Following CHECK back to the
+    // parent, whose chain ends at the root, rules out cycles downwards;
+    // ascending labels rule them out among siblings.
+    const int32_t next = child( unit, label );
+    if ( next < 0 )
+      return;
+    path.push_back( static_cast< char >( label ) );
+    collect( next, path, out );
+    path.pop_back();
+    label = nextSibling( next, label );
+  }
+}
+
+/*!
+  Appends the words below 'unit' (which spells 'path') to 'out' until it
+  holds 'limit' words, leaving out the first 'skip'. Subtrees that lie
+  completely in front of the page are skipped by their word count.
+  */
+void DoubleArrayTrie_c::collectPage( int32_t unit, std::string& path, size_t& skip, size_t limit,
+    std::vector< std::string >& out ) const
+{
+  if ( out.size() >= limit )
+    return;
+  if ( skip >= _units[ unit ]._wordCount )
+  {
+    skip -= _units[ unit ]._wordCount;
+    return;
+  }
+
+  if ( _units[ unit ]._isLeaf )
+  {
+    if ( skip > 0 )
+      --skip;
+    else
+      out.push_back( path );
+  }
+
+  // checked like in collect(), the units may come from an image
+  for ( uint16_t label = _units[ unit ]._firstChild; label < kNoLabel && out.size() < limit; )
+  {
+    const int32_t next = child( unit, label );
+    if ( next < 0 )
+      return;
+    path.push_back( static_cast< char >( label ) );
+    collectPage( next, path, skip, limit, out );
+    path.pop_back();
+    label = nextSibling( next, label );
+  }
+}
+
+bool DoubleArrayTrie_c::containsPrefix( const std::string& prefix ) const
+{
+  return descend( prefix ) >= 0;
+}
+
+void DoubleArrayTrie_c::findPrefixMatches( const std::string& prefix,
+    std::vector< std::string >& out ) const
+{
+  const int32_t unit = descend( prefix );
+  if ( unit < 0 )
+    return;
+
+  std::string path = prefix;
+  collect( unit, path, out );
+}
+
+size_t DoubleArrayTrie_c::countPrefixMatches( const std::string& prefix ) const
+{
+  const int32_t unit = descend( prefix );
+  return unit < 0 ? 0 : _units[ unit ]._wordCount;
+}
+
+bool DoubleArrayTrie_c::findPage( const std::string& prefix, size_t skip, size_t limit,
+    std::vector< std::string >& out ) const
+{
+  const int32_t unit = descend( prefix );
+  if ( unit < 0 )
+    return false;
+
+  const size_t before = out.size();
+  std::string path = prefix;
+  size_t toSkip = skip;
+  collectPage( unit, path, toSkip, pageEnd( before, limit ), out );
+  return skip + ( out.size() - before ) < _units[ unit ]._wordCount;
+}
+
+size_t DoubleArrayTrie_c::countUpTo( const std::string& prefix, const std::string& last ) const
+{
+  int32_t unit = descend( prefix );
+  if ( unit < 0 )
+    return 0;
+  const int place = placeLast( prefix, last );
+  if ( place != 0 )
+    return place > 0 ? _units[ unit ]._wordCount : 0;
+
+  size_t count = 0;
+  for ( size_t depth = prefix.size(); ; ++depth )
+  {
+    // the word spelled here is a prefix of 'last', or 'last' itself
+    if ( _units[ unit ]._isLeaf )
+      ++count;
+    if ( depth == last.size() )
+      return count;
+
+    // the siblings in front of 'key' are visited in order, their words
+    // are all smaller than 'last'
+    const auto key = static_cast< unsigned char >( last[ depth ] );
+    uint16_t label = _units[ unit ]._firstChild;
+    while ( label < key )
+    {
+      const int32_t sibling = child( unit, label );
+      if ( sibling < 0 )
+        return count;
+      count += _units[ sibling ]._wordCount;
+      label = nextSibling( sibling, label );
+    }
+    if ( label != key )
+      return count;
+    unit = child( unit, label );
+    if ( unit < 0 )
+      return count;
+  }
+}
+
+size_t DoubleArrayTrie_c::memoryUsage() const
+{
+  return sizeof( *this ) + _storage.capacity() * sizeof( DaUnit_t );
+}
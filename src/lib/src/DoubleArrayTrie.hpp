@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FrozenTrie.hpp"
+#include "include/NodeArena.hpp"
+
+/*!
+  Double-array trie: the child of unit s on byte c is unit t = BASE[s] + c,
+  valid iff CHECK[t] == s. A prefix descent costs one unit access per byte.
+  Every unit additionally keeps the byte of its first child and of its next
+  sibling so that subtrees can be enumerated in order without probing all
+  256 codes.
+  */
+class DoubleArrayTrie_c : public FrozenTrie_c
+{
+public:
+  static constexpr uint16_t kNoLabel = 0x100;
+
+  // plain old data, also the on-disk unit format of TrieImage_c
+  struct DaUnit_t
+  {
+    int32_t _base = 0;
+    int32_t _check = -1; // parent unit, -1 while the unit is free
+    // number of words below the unit, for countPrefixMatches
+    uint32_t _wordCount = 0;
+    uint16_t _firstChild = kNoLabel;
+    uint16_t _nextSibling = kNoLabel;
+    // a byte rather than bool: any value read from an image is valid
+    uint8_t _isLeaf = 0;
+    // spelled out, so that images hold no indeterminate padding bytes
+    uint8_t _reserved[ 3 ] = {};
+  };
+
+  explicit DoubleArrayTrie_c( const NodeArena_c& arena );
+  // non-owning view on units kept alive by the caller, e.g. a mapped file
+  DoubleArrayTrie_c( const DaUnit_t* units, size_t unitCount );
+
+  bool containsPrefix( const std::string& prefix ) const override;
+  void findPrefixMatches( const std::string& prefix,
+      std::vector< std::string >& out ) const override;
+  size_t countPrefixMatches( const std::string& prefix ) const override;
+  bool findPage( const std::string& prefix, size_t skip, size_t limit,
+      std::vector< std::string >& out ) const override;
+  size_t countUpTo( const std::string& prefix, const std::string& last ) const override;
+
+  size_t memoryUsage() const override;
+
+  const DaUnit_t* units() const { return _units; }
+  size_t unitCount() const { return _unitCount; }
+
+private:
+  int32_t descend( const std::string& prefix ) const;
+  void collect( int32_t unit, std::string& path,
+      std::vector< std::string >& out ) const;
+  void collectPage( int32_t unit, std::string& path, size_t& skip, size_t limit,
+      std::vector< std::string >& out ) const;
+  // the child of 'unit' on 'label', -1 if there is none
+  int32_t child( int32_t unit, uint16_t label ) const
+  {
+    const size_t next = static_cast< size_t >( _units[ unit ]._base ) + label;
+    if ( next >= _unitCount || _units[ next ]._check != unit )
+      return -1;
+    return static_cast< int32_t >( next );
+  }
+  // the label of the sibling behind 'unit', which was reached on 'label';
+  // kNoLabel at the end, and for units from an image that do not keep their
+  // siblings ascending, so a walk cannot go round in circles
+  uint16_t nextSibling( int32_t unit, uint16_t label ) const
+  {
+    const uint16_t next = _units[ unit ]._nextSibling;
+    return next > label ? next : kNoLabel;
+  }
+
+  // empty for views
+  std::vector< DaUnit_t > _storage;
+  const DaUnit_t* _units = nullptr;
+  size_t _unitCount = 0;
+};
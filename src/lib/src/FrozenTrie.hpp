@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+/*!
+  Read-only serving representation of a Trie_c, produced by Trie_c::freeze().
+  Implementations are immutable after construction and may be queried from
+  any number of threads at once.
+  */
+class FrozenTrie_c
+{
+public:
+  virtual ~FrozenTrie_c() = default;
+
+  // true if at least one word starts with 'prefix'
+  virtual bool containsPrefix( const std::string& prefix ) const = 0;
+
+  // appends all words starting with 'prefix' to 'out', in lexicographic order
+  virtual void findPrefixMatches( const std::string& prefix,
+      std::vector< std::string >& out ) const = 0;
+
+  // number of words starting with 'prefix', read from per-node word counts
+  // after a descent of |prefix| steps, never by enumerating them
+  virtual size_t countPrefixMatches( const std::string& prefix ) const = 0;
+
+  /*!
+    Appends at most 'limit' of the words starting with 'prefix' to 'out', in
+    lexicographic order, leaving out the first 'skip'. Subtrees in front of
+    the page are stepped over by their word counts and the walk stops once
+    the page is full. Returns true if more words follow the page.
+    */
+  virtual bool findPage( const std::string& prefix, size_t skip, size_t limit,
+      std::vector< std::string >& out ) const = 0;
+
+  // number of words starting with 'prefix' that are not greater than 'last':
+  // follows 'last' down a single path, adding up the word counts left of it
+  virtual size_t countUpTo( const std::string& prefix, const std::string& last ) const = 0;
+
+  virtual size_t memoryUsage() const = 0;
+
+protected:
+  // size of 'out' once a page of at most 'limit' words follows its first
+  // 'before', without overflowing for an unlimited page
+  static size_t pageEnd( size_t before, size_t limit )
+  {
+    return before + std::min( limit, std::numeric_limits< size_t >::max() - before );
+  }
+
+  // where 'last' falls relative to the words starting with 'prefix': 1 if
+  // behind all of them, -1 if in front of all of them, 0 if it starts with
+  // 'prefix' itself and so falls among them
+  static int placeLast( const std::string& prefix, const std::string& last )
+  {
+    const size_t common = std::min( prefix.size(), last.size() );
+    const int order = prefix.compare( 0, common, last, 0, common );
+    if ( order != 0 )
+      return order < 0 ? 1 : -1;
+    return prefix.size() > last.size() ? -1 : 0;
+  }
+};
@@ -0,0 +1,104 @@
+#include <bitset>
+#include <stdexcept>
+
+#include "GlobPattern.hpp"
+
+GlobPattern_c::GlobPattern_c( std::string_view pattern )
+{
+  size_t numItems = 0;
+  bool literalsOnly = true;
+  for ( size_t pos = 0; pos < pattern.size(); ++pos )
+  {
+    const char c = pattern[ pos ];
+    // "**" is the same as "*", and keeping stars apart makes one closure
+    // step enough
+    if ( c == '*' && numItems > 0 && ( _stars >> ( numItems - 1 ) ) & 1 )
+      continue;
+    if ( numItems == 63 )
+      throw std::invalid_argument( "GlobPattern_c: more than 63 items" );
+
+    const State_t bit = State_t( 1 ) << numItems;
+    std::bitset< 256 > set;
+    if ( c == '*' )
+    {
+      _stars |= bit;
+      literalsOnly = false;
+    }
+    else if ( c == '?' )
+    {
+      set.set();
+      literalsOnly = false;
+    }
+    else if ( c == '[' )
+    {
+      size_t end = pos + 1;
+      const bool negate = end < pattern.size() && ( pattern[ end ] == '!' || pattern[ end ] == '^' );
+      end += negate;
+      // a ']' right after the opening bracket is a member
+      const size_t first = end;
+      while ( end < pattern.size() && ( pattern[ end ] != ']' || end == first ) )
+        ++end;
+      if ( end == pattern.size() )
+        throw std::invalid_argument( "GlobPattern_c: unterminated '['" );
+
+      for ( size_t i = first; i < end; ++i )
+      {
+        const uint8_t low = static_cast< uint8_t >( pattern[ i ] );
+        if ( i + 2 < end && pattern[ i + 1 ] == '-' )
+        {
+          for ( unsigned b = low; b <= static_cast< uint8_t >( pattern[ i + 2 ] ); ++b )
+            set.set( b );
+          i += 2;
+        }
+        else
+          set.set( low );
+      }
+      if ( negate )
+        set.flip();
+      pos = end;
+      literalsOnly = false;
+    }
+    else
+    {
+      if ( c == '\\' )
+      {
+        if ( ++pos == pattern.size() )
+          throw std::invalid_argument( "GlobPattern_c: trailing '\\'" );
+      }
+      set.set( static_cast< uint8_t >( pattern[ pos ] ) );
+      _single |= bit;
+      _literals[ numItems ] = pattern[ pos ];
+      if ( literalsOnly )
+        _literalPrefix.push_back( pattern[ pos ] );
+    }
+
+    for ( size_t b = 0; b < 256; ++b )
+      if ( set.test( b ) )
+        _accepts[ b ] |= bit;
+    ++numItems;
+  }
+
+  _final = State_t( 1 ) << numItems;
+  if ( numItems > 0 && ( _stars >> ( numItems - 1 ) ) & 1 )
+    _openEnd = State_t( 1 ) << ( numItems - 1 );
+  _start = closure( 1 );
+}
+
+bool GlobPattern_c::onlyByte( State_t state, char & letter ) const
+{
+  const State_t live = state & ~_final;
+  if ( live == 0 || ( live & ~_single ) )
+    return false;
+
+  bool found = false;
+  for ( size_t i = 0; i < 63; ++i )
+  {
+    if ( !( ( live >> i ) & 1 ) )
+      continue;
+    if ( found && _literals[ i ] != letter )
+      return false;
+    letter = _literals[ i ];
+    found = true;
+  }
+  return true;
+}
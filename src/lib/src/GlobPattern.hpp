@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*!
+  A glob pattern compiled to a bit-parallel NFA. Syntax, matched per byte:
+  '?' any byte, '*' any run of bytes, '[abc]' and '[a-z]' a set of bytes,
+  '[!abc]' or '[^abc]' the complement, '\x' the literal x.
+  NFA state i stands for "the first i pattern items are matched", so a set of
+  states fits in one 64-bit word and advancing it by a byte is a table
+  lookup, a shift and a few masks. The empty set means no continuation can
+  match any more, which is what lets a traversal prune.
+  */
+class GlobPattern_c
+{
+public:
+  using State_t = uint64_t;
+
+  // throws std::invalid_argument for an unterminated set, a trailing '\'
+  // or more than 63 items
+  explicit GlobPattern_c( std::string_view pattern );
+
+  State_t start() const { return _start; }
+  State_t step( State_t state, char letter ) const
+  {
+    const State_t moved = ( ( state & _accepts[ static_cast< uint8_t >( letter ) ] ) << 1 )
+      | ( state & _stars );
+    return closure( moved );
+  }
+  State_t step( State_t state, std::string_view text ) const
+  {
+    for ( size_t i = 0; i < text.size() && state; ++i )
+      state = step( state, text[ i ] );
+    return state;
+  }
+
+  bool accepts( State_t state ) const { return state & _final; }
+  // the pattern ends in '*' and got there: every continuation matches
+  bool acceptsAnySuffix( State_t state ) const { return state & _openEnd; }
+  /*!
+    Stores the one byte that 'state' can continue with in 'letter', if there
+    is exactly one, i.e. all live states wait for the same literal.
+    */
+  bool onlyByte( State_t state, char& letter ) const;
+
+  // the bytes every match starts with
+  const std::string& literalPrefix() const { return _literalPrefix; }
+  bool matches( std::string_view text ) const { return accepts( step( _start, text ) ); }
+
+private:
+  // states behind a '*' are entered for free
+  State_t closure( State_t state ) const { return state | ( ( state & _stars ) << 1 ); }
+
+  // bit i of _accepts[ c ]: item i is a byte set containing c
+  std::array< State_t, 256 > _accepts{};
+  // bit i: item i is a '*'
+  State_t _stars = 0;
+  // bit i: item i is a single literal byte, stored in _literals[ i ]
+  State_t _single = 0;
+  std::array< char, 64 > _literals{};
+  State_t _start = 0;
+  State_t _final = 0;
+  State_t _openEnd = 0;
+  std::string _literalPrefix;
+};
@@ -0,0 +1,240 @@
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "LoudsTrie.hpp"
+
+namespace
+{
+  constexpr uint32_t kNoChild = std::numeric_limits< uint32_t >::max();
+
+  // a byte position in the arena: 'consumed' bytes of node's label are spelled
+  struct Position_t
+  {
+    NodeIndex_t _node;
+    uint32_t _consumed;
+  };
+}
+
+LoudsTrie_c::LoudsTrie_c( const NodeArena_c& arena )
+{
+  std::deque< Position_t > queue;
+  queue.push_back( { arena.root(), 0 } );
+  _labels.push_back( '\0' );
+
+  // super root
+  _louds.push_back( true );
+  _louds.push_back( false );
+
+  while ( !queue.empty() )
+  {
+    const Position_t pos = queue.front();
+    queue.pop_front();
+
+    const TrieNode_t& node = arena[ pos._node ];
+    const std::string_view label = arena.label( pos._node );
+    // a position inside a radix edge leads to the same words as its node
+    _wordCounts.push_back( node._wordCount );
+    if ( pos._consumed < label.size() )
+    {
+      // inside a radix edge: exactly one child
+      _terminal.push_back( false );
+      _louds.push_back( true );
+      _labels.push_back( label[ pos._consumed ] );
+      queue.push_back( { pos._node, pos._consumed + 1 } );
+    }
+    else
+    {
+      _terminal.push_back( node._isLeaf );
+      arena.forEachChild( pos._node, [ & ]( NodeIndex_t child )
+      {
+        _louds.push_back( true );
+        _labels.push_back( arena[ child ]._letter );
+        queue.push_back( { child, 1 } );
+      } );
+    }
+    _louds.push_back( false );
+  }
+
+  _louds.build();
+  _terminal.build();
+  _labels.shrink_to_fit();
+  _wordCounts.shrink_to_fit();
+}
+
+void LoudsTrie_c::childRange( uint32_t node, uint32_t& first, uint32_t& count ) const
+{
+  // the block of 'node' starts right behind its zero in the level order
+  const size_t start = _louds.select0( node ) + 1;
+  first = static_cast< uint32_t >( _louds.rank1( start ) );
+  size_t end = start;
+  while ( end < _louds.size() && _louds[ end ] )
+    ++end;
+  count = static_cast< uint32_t >( end - start );
+}
+
+uint32_t LoudsTrie_c::findChild( uint32_t node, char letter ) const
+{
+  uint32_t first;
+  uint32_t count;
+  childRange( node, first, count );
+
+  // siblings are sorted by unsigned byte value
+  const auto key = static_cast< unsigned char >( letter );
+  for ( uint32_t child = first; child < first + count; ++child )
+  {
+    const auto childKey = static_cast< unsigned char >( _labels[ child ] );
+    if ( childKey == key )
+      return child;
+    if ( childKey > key )
+      break;
+  }
+  return kNoChild;
+}
+
+void LoudsTrie_c::collect( uint32_t node, std::string& path,
+    std::vector< std::string >& out ) const
+{
+  if ( _terminal[ node ] )
+    out.push_back( path );
+
+  uint32_t first;
+  uint32_t count;
+  childRange( node, first, count );
+  for ( uint32_t child = first; child < first + count; ++child )
+  {
+    path.push_back( _labels[ child ] );
+    collect( child, path, out );
+    path.pop_back();
+  }
+}
+
+/*!
+  Appends the words below 'node' (which spells 'path') to 'out' until it
+  holds 'limit' words, leaving out the first 'skip'. Subtrees that lie
+  completely in front of the page are skipped by their word count.
+  */
+void LoudsTrie_c::collectPage( uint32_t node, std::string& path, size_t& skip, size_t limit,
+    std::vector< std::string >& out ) const
+{
+  if ( out.size() >= limit )
+    return;
+  if ( skip >= _wordCounts[ node ] )
+  {
+    skip -= _wordCounts[ node ];
+    return;
+  }
+
+  if ( _terminal[ node ] )
+  {
+    if ( skip > 0 )
+      --skip;
+    else
+      out.push_back( path );
+  }
+
+  uint32_t first;
+  uint32_t count;
+  childRange( node, first, count );
+  for ( uint32_t child = first; child < first + count && out.size() < limit; ++child )
+  {
+    path.push_back( _labels[ child ] );
+    collectPage( child, path, skip, limit, out );
+    path.pop_back();
+  }
+}
+
+uint32_t LoudsTrie_c::descend( const std::string& prefix ) const
+{
+  uint32_t node = 0;
+  for ( const char letter : prefix )
+  {
+    node = findChild( node, letter );
+    if ( node == kNoChild )
+      break;
+  }
+  return node;
+}
+
+bool LoudsTrie_c::containsPrefix( const std::string& prefix ) const
+{
+  return descend( prefix ) != kNoChild;
+}
+
+void LoudsTrie_c::findPrefixMatches( const std::string& prefix,
+    std::vector< std::string >& out ) const
+{
+  const uint32_t node = descend( prefix );
+  if ( node == kNoChild )
+    return;
+
+  std::string path = prefix;
+  collect( node, path, out );
+}
+
+size_t LoudsTrie_c::countPrefixMatches( const std::string& prefix ) const
+{
+  const uint32_t node = descend( prefix );
+  return node == kNoChild ? 0 : _wordCounts[ node ];
+}
+
+bool LoudsTrie_c::findPage( const std::string& prefix, size_t skip, size_t limit,
+    std::vector< std::string >& out ) const
+{
+  const uint32_t node = descend( prefix );
+  if ( node == kNoChild )
+    return false;
+
+  const size_t before = out.size();
+  std::string path = prefix;
+  size_t toSkip = skip;
+  collectPage( node, path, toSkip, pageEnd( before, limit ), out );
+  return skip + ( out.size() - before ) < _wordCounts[ node ];
+}
+
+size_t LoudsTrie_c::countUpTo( const std::string& prefix, const std::string& last ) const
+{
+  uint32_t node = descend( prefix );
+  if ( node == kNoChild )
+    return 0;
+  const int place = placeLast( prefix, last );
+  if ( place != 0 )
+    return place > 0 ? _wordCounts[ node ] : 0;
+
+  size_t count = 0;
+  for ( size_t depth = prefix.size(); ; ++depth )
+  {
+    // the word spelled here is a prefix of 'last', or 'last' itself
+    if ( _terminal[ node ] )
+      ++count;
+    if ( depth == last.size() )
+      return count;
+
+    uint32_t first;
+    uint32_t numChildren;
+    childRange( node, first, numChildren );
+    const auto key = static_cast< unsigned char >( last[ depth ] );
+    uint32_t next = kNoChild;
+    for ( uint32_t child = first; child < first + numChildren; ++child )
+    {
+      const auto childKey = static_cast< unsigned char >( _labels[ child ] );
+      if ( childKey < key )
+        count += _wordCounts[ child ];
+      else
+      {
+        if ( childKey == key )
+          next = child;
+        break;
+      }
+    }
+    if ( next == kNoChild )
+      return count;
+    node = next;
+  }
+}
+
+size_t LoudsTrie_c::memoryUsage() const
+{
+  return sizeof( *this ) + _louds.memoryUsage() + _terminal.memoryUsage()
+    + _labels.capacity() + _wordCounts.capacity() * sizeof( uint32_t );
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "FrozenTrie.hpp"
+#include "include/BitVector.hpp"
+#include "include/NodeArena.hpp"
+
+/*!
+  Succinct trie in level-order unary degree sequence (LOUDS) encoding.
+  Nodes are numbered in breadth-first order, the root is 0. Every node
+  contributes its degree in unary ("1...10") to _louds, preceded by the
+  super root "10". Radix edges are expanded into one node per byte, so each
+  node costs about two LOUDS bits, one terminal bit and one label byte, plus
+  a 32-bit count of the words below it for countPrefixMatches. The subtree of
+  a node is not contiguous in level order, so these counts cannot be derived
+  by rank.
+  */
+class LoudsTrie_c : public FrozenTrie_c
+{
+public:
+  explicit LoudsTrie_c( const NodeArena_c& arena );
+
+  bool containsPrefix( const std::string& prefix ) const override;
+  void findPrefixMatches( const std::string& prefix,
+      std::vector< std::string >& out ) const override;
+  size_t countPrefixMatches( const std::string& prefix ) const override;
+  bool findPage( const std::string& prefix, size_t skip, size_t limit,
+      std::vector< std::string >& out ) const override;
+  size_t countUpTo( const std::string& prefix, const std::string& last ) const override;
+
+  size_t memoryUsage() const override;
+
+  size_t nodeCount() const { return _labels.size(); }
+
+private:
+  // first child id and number of children of 'node'
+  void childRange( uint32_t node, uint32_t& first, uint32_t& count ) const;
+  uint32_t findChild( uint32_t node, char letter ) const;
+  uint32_t descend( const std::string& prefix ) const;
+  void collect( uint32_t node, std::string& path,
+      std::vector< std::string >& out ) const;
+  void collectPage( uint32_t node, std::string& path, size_t& skip, size_t limit,
+      std::vector< std::string >& out ) const;
+
+  BitVector_c _louds;
+  BitVector_c _terminal;
+  // _labels[ id ] is the byte on the edge into node id, _labels[ 0 ] is unused
+  std::string _labels;
+  // number of words in the subtree of node id
+  std::vector< uint32_t > _wordCounts;
+};
@@ -0,0 +1,43 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "MappedFile.hpp"
+
+MappedFile_c::MappedFile_c( const std::string& path )
+{
+  const int fd = ::open( path.c_str(), O_RDONLY );
+  if ( fd < 0 )
+    throw std::runtime_error( "MappedFile_c: unable to open " + path );
+
+  struct stat info;
+  if ( ::fstat( fd, &info ) != 0 )
+  {
+    ::close( fd );
+    throw std::runtime_error( "MappedFile_c: unable to stat " + path );
+  }
+
+  _size = static_cast< size_t >( info.st_size );
+  if ( _size > 0 )
+  {
+    void* mapped = ::mmap( nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( mapped == MAP_FAILED )
+    {
+      ::close( fd );
+      throw std::runtime_error( "MappedFile_c: unable to map " + path );
+    }
+    _data = static_cast< const char* >( mapped );
+  }
+  // the mapping stays valid after the descriptor is closed
+  ::close( fd );
+}
+
+MappedFile_c::~MappedFile_c()
+{
+  if ( _data )
+    ::munmap( const_cast< char* >( _data ), _size );
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*!
+  Read-only memory mapping of a whole file, unmapped on destruction.
+  Throws std::runtime_error if the file cannot be opened or mapped.
+  */
+class MappedFile_c
+{
+public:
+  explicit MappedFile_c( const std::string& path );
+  MappedFile_c( const MappedFile_c& ) = delete;
+  MappedFile_c& operator=( const MappedFile_c& ) = delete;
+  ~MappedFile_c();
+
+  const char* data() const { return _data; }
+  size_t size() const { return _size; }
+
+private:
+  const char* _data = nullptr;
+  size_t _size = 0;
+};
@@ -0,0 +1,41 @@
+#include <utility>
+
+#include "PrefixCursor.hpp"
+
+PrefixCursor_c::PrefixCursor_c( const NodeArena_c & arena, NodeIndex_t start, std::string path ) :
+  _arena( &arena ), _path( std::move( path ) )
+{
+  if ( start != kNullNode )
+    _stack.push_back( { start, static_cast< uint32_t >( _path.size() ), 0, false } );
+}
+
+/*!
+  Pre-order walk on an explicit stack. A node reports its word when it is
+  entered; afterwards its children are visited one by one, each spelled by
+  cutting the buffer back to the parent's word and appending the edge label.
+  */
+bool PrefixCursor_c::next()
+{
+  while ( !_stack.empty() )
+  {
+    Frame_t& top = _stack.back();
+    if ( !top._entered )
+    {
+      top._entered = true;
+      if ( ( *_arena )[ top._node ]._isLeaf )
+        return true;
+    }
+
+    const NodeIndex_t child = _arena->nextChild( top._node, top._nextChild );
+    if ( child == kNullNode )
+    {
+      _stack.pop_back();
+      continue;
+    }
+
+    _path.resize( top._length );
+    _path.append( _arena->label( child ) );
+    _stack.push_back( { child, static_cast< uint32_t >( _path.size() ), 0, false } );
+  }
+  return false;
+}
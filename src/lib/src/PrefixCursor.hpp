@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "include/NodeArena.hpp"
+
+/*!
+  Lazy, in-order enumeration of the words below one node of a NodeArena_c.
+  Nothing is collected up front: every next() walks just far enough to reach
+  the following word, and all words are spelled in one reusable buffer. The
+  std::string_view returned by word() stays valid until the next step.
+  The arena must outlive the cursor and must not change while it is used.
+  */
+class PrefixCursor_c
+{
+public:
+  class iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = std::string_view;
+
+    iterator() = default;
+    explicit iterator( PrefixCursor_c* cursor ) : _cursor( cursor ) { advance(); }
+
+    std::string_view operator*() const { return _cursor->word(); }
+    iterator& operator++() { advance(); return *this; }
+    bool operator==( const iterator& other ) const { return _cursor == other._cursor; }
+    bool operator!=( const iterator& other ) const { return _cursor != other._cursor; }
+
+  private:
+    void advance()
+    {
+      if ( !_cursor->next() )
+        _cursor = nullptr;
+    }
+
+    PrefixCursor_c* _cursor = nullptr;
+  };
+
+  // an exhausted cursor
+  PrefixCursor_c() = default;
+  // enumerates the subtree of 'start', which spells 'path'
+  PrefixCursor_c( const NodeArena_c& arena, NodeIndex_t start, std::string path );
+
+  // steps to the next word, false once there is none
+  bool next();
+  std::string_view word() const { return _path; }
+
+  // single pass: iterating consumes the cursor
+  iterator begin() { return iterator( this ); }
+  iterator end() { return iterator(); }
+
+private:
+  struct Frame_t
+  {
+    NodeIndex_t _node;
+    // length of the word spelled by _node
+    uint32_t _length;
+    // NodeArena_c::nextChild cursor
+    uint32_t _nextChild;
+    bool _entered;
+  };
+
+  const NodeArena_c* _arena = nullptr;
+  std::string _path;
+  std::vector< Frame_t > _stack;
+};
@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <iterator>
+
+#include "QuerySession.hpp"
+#include "Trie.hpp"
+
+QuerySession_c::QuerySession_c( const Trie_c & trie ) :
+  _trie( trie )
+{
+}
+
+QuerySession_c::~QuerySession_c()
+{
+  cancel();
+}
+
+QueryHandle_c QuerySession_c::findPrefixMatches( const std::string & prefix )
+{
+  // an awaiter of the superseded query resumes once this one is set up
+  const std::function< void() > superseded = stop();
+  _state = std::make_shared< QueryState_t >();
+  QueryHandle_c handle( _state );
+  if ( _trieVersion != _trie._version )
+  {
+    // the trie changed since the last query, nothing cached is valid
+    _trieVersion = _trie._version;
+    _prefix.clear();
+    _steps.clear();
+    _resultsComplete = false;
+  }
+
+  if ( narrowResults( prefix ) )
+  {
+    _prefix = prefix;
+    deliver();
+    if ( superseded )
+      superseded();
+    return handle;
+  }
+  clearResults();
+
+  if ( _trie._frozen )
+  {
+    {
+      std::lock_guard< std::mutex > guard( _accessResults );
+      _trie._frozen->findPrefixMatches( prefix, _results );
+    }
+    _prefix = prefix;
+    _resultsComplete = true;
+    deliver();
+    if ( superseded )
+      superseded();
+    return handle;
+  }
+
+  std::string path;
+  const NodeIndex_t reachedNode = resume( prefix, path );
+  if ( reachedNode == kNullNode )
+  {
+    _resultsComplete = true;
+    deliver();
+    if ( superseded )
+      superseded();
+    return handle;
+  }
+
+  {
+    std::lock_guard< std::mutex > guard( _accessQuery );
+    _queryRunning = true;
+  }
+  spawnTraversal( reachedNode, path, newSegment(), _epoch.load() );
+  if ( superseded )
+    superseded();
+  return handle;
+}
+
+/*!
+  Walks down along 'prefix' like Trie_c::descend, but starts at the deepest
+  step cached for the common prefix with the last query and caches the new
+  steps. Returns the node whose subtree holds all matches (or kNullNode) and
+  the word it spells in 'path'.
+  */
+NodeIndex_t QuerySession_c::resume( const std::string & prefix, std::string & path )
+{
+  const NodeArena_c& arena = _trie._arena;
+
+  size_t common = 0;
+  while ( common < _prefix.size() && common < prefix.size() && _prefix[ common ] == prefix[ common ] )
+    ++common;
+  _prefix = prefix;
+
+  // going back (or sideways) pops to the ancestor, going on extends
+  if ( _steps.empty() )
+    _steps.push_back( { arena.root(), 0 } );
+  _steps.resize( std::min( _steps.size(), common + 1 ) );
+
+  while ( _steps.size() <= prefix.size() )
+  {
+    Step_t step = _steps.back();
+    const char letter = prefix[ _steps.size() - 1 ];
+    const std::string_view label = arena.label( step._node );
+    if ( step._offset < label.size() )
+    {
+      // still inside a radix edge
+      if ( label[ step._offset ] != letter )
+        return kNullNode;
+      ++step._offset;
+    }
+    else
+    {
+      step._node = arena.findChild( step._node, letter );
+      if ( step._node == kNullNode )
+        return kNullNode;
+      step._offset = 1;
+    }
+    _steps.push_back( step );
+  }
+
+  const Step_t& last = _steps.back();
+  path = prefix;
+  path.append( arena.label( last._node ).substr( last._offset ) );
+  return last._node;
+}
+
+/*!
+  If 'prefix' extends the prefix of the last, completed query, cuts the
+  previous result down to the matches of 'prefix'. They are a contiguous run
+  of the sorted result, so this costs a binary search and a move.
+  */
+bool QuerySession_c::narrowResults( const std::string & prefix )
+{
+  if ( !_resultsComplete || prefix.compare( 0, _prefix.size(), _prefix ) != 0 )
+    return false;
+
+  std::lock_guard< std::mutex > guard( _accessResults );
+  const auto begin = std::lower_bound( _results.begin(), _results.end(), prefix );
+  auto end = begin;
+  while ( end != _results.end() && end->compare( 0, prefix.size(), prefix ) == 0 )
+    ++end;
+  _results.erase( end, _results.end() );
+  _results.erase( _results.begin(), begin );
+  return true;
+}
+
+/*!
+  Cancels the running query, if any, and sleeps until its last task is gone.
+  Cancelled tasks notice the new epoch at the next node they visit.
+  */
+void QuerySession_c::cancel()
+{
+  if ( const std::function< void() > continuation = stop() )
+    continuation();
+}
+
+std::function< void() > QuerySession_c::stop()
+{
+  ++_epoch;
+
+  std::unique_lock< std::mutex > lock( _accessQuery );
+  _queryDone.wait( lock, [ this ] { return !_queryRunning; } );
+  return _state->complete( nullptr );
+}
+
+void QuerySession_c::deliver()
+{
+  const std::shared_ptr< QueryState_t > state = _state;
+  const callback done = onFinnishedSearch;
+  const std::function< void() > continuation = state->complete( &_results );
+  done( state->_future.get() );
+  if ( continuation )
+    continuation();
+}
+
+std::function< void() > QueryState_t::complete( const std::vector< std::string > * results )
+{
+  std::function< void() > continuation;
+  {
+    std::lock_guard< std::mutex > guard( _access );
+    if ( _done )
+      return continuation;
+    _done = true;
+    if ( results )
+      _promise.set_value( *results );
+    else
+      _promise.set_exception( std::make_exception_ptr( QueryCancelled_c() ) );
+    continuation.swap( _continuation );
+  }
+  return continuation;
+}
+
+bool QueryState_t::suspend( std::function< void() > resume )
+{
+  std::lock_guard< std::mutex > guard( _access );
+  if ( _done )
+    return false;
+  _continuation = std::move( resume );
+  return true;
+}
+
+std::vector< std::string > QuerySession_c::requestResult() const
+{
+  std::lock_guard< std::mutex > guard( _accessResults );
+  return _results;
+}
+
+void QuerySession_c::setCallback( const callback & cb ) { onFinnishedSearch = cb; }
+
+/*!
+  Private helper function to perform depth-first traversal, a.k.a pre-order traversal
+  Given the root of the sub-trie under prefix, traverse all nodes in depth-first order
+  to reach the leaves. 'path' holds the word spelled by 'rootSubT' and is
+  reused for all words below it.
+  */
+void QuerySession_c::traverse( NodeIndex_t rootSubT, std::string & path,
+    ResultSegment_t*& segment, uint64_t epoch )
+{
+  // a superseded query gives up at the next node
+  if ( cancelled( epoch ) )
+    return;
+
+  const NodeArena_c& arena = _trie._arena;
+  const TrieNode_t& node = arena[ rootSubT ];
+  if ( node._isLeaf )
+    segment->_words.push_back( path );
+
+  // paths diverge: big subtrees become tasks other workers can steal,
+  // small ones are cheaper to walk right here
+  const bool branches = node._childCount > 1;
+  const size_t length = path.size();
+  arena.forEachChild( rootSubT, [ & ]( NodeIndex_t tnIdx )
+  {
+    path.resize( length );
+    path.append( arena.label( tnIdx ) );
+    if ( branches && _trie._pool && arena[ tnIdx ]._wordCount >= kMinTaskWords )
+    {
+      // the task fills its own segment, we continue in a fresh one behind it
+      ResultSegment_t* taskSegment = newSegment();
+      ResultSegment_t* behind = newSegment();
+      behind->_next = segment->_next;
+      taskSegment->_next = behind;
+      segment->_next = taskSegment;
+
+      spawnTraversal( tnIdx, path, taskSegment, epoch );
+      segment = behind;
+    }
+    else
+    {
+      traverse( tnIdx, path, segment, epoch );
+    }
+  } );
+  path.resize( length );
+}
+
+void QuerySession_c::spawnTraversal( NodeIndex_t rootSubT, const std::string & word,
+    ResultSegment_t * segment, uint64_t epoch )
+{
+  ++_pendingTasks;
+  if ( !_trie._pool )
+  {
+    // a trie without workers answers on the caller's thread
+    std::string path = word;
+    traverse( rootSubT, path, segment, epoch );
+    finishTask( epoch );
+    return;
+  }
+  // the task spells its words in its own copy of the path
+  _trie._pool->submit( [ this, rootSubT, path = word, segment, epoch ]() mutable
+  {
+    traverse( rootSubT, path, segment, epoch );
+    finishTask( epoch );
+  } );
+}
+
+void QuerySession_c::finishTask( uint64_t epoch )
+{
+  if ( --_pendingTasks != 0 )
+    return;
+
+  // the last task merges the buffers and calls the callback function,
+  // unless the query was cancelled meanwhile
+  const std::shared_ptr< QueryState_t > state = _state;
+  std::function< void() > continuation;
+  callback done;
+  if ( cancelled( epoch ) )
+  {
+    continuation = state->complete( nullptr );
+  }
+  else
+  {
+    mergeResults();
+    _resultsComplete = true;
+    continuation = state->complete( &_results );
+    done = onFinnishedSearch;
+  }
+
+  {
+    // notified under the lock: once the flag is down a waiter may destroy
+    // the session, condition variable included
+    std::lock_guard< std::mutex > guard( _accessQuery );
+    _queryRunning = false;
+    _queryDone.notify_all();
+  }
+
+  // the session is free now: the callback and the awaiter may start the
+  // next query or destroy the session, so only locals are used from here
+  if ( done )
+    done( state->_future.get() );
+  if ( continuation )
+    continuation();
+}
+
+ResultSegment_t* QuerySession_c::newSegment()
+{
+  std::lock_guard< std::mutex > guard( _accessSegments );
+  _segments.emplace_back();
+  return &_segments.back();
+}
+
+/*!
+  Concatenates the segments in list order, which is lexicographic order
+  because every task walks its subtree depth-first in key order.
+  */
+void QuerySession_c::mergeResults()
+{
+  std::lock_guard< std::mutex > guard( _accessResults );
+  size_t total = 0;
+  for ( const ResultSegment_t* seg = &_segments.front(); seg; seg = seg->_next )
+    total += seg->_words.size();
+
+  _results.reserve( total );
+  for ( ResultSegment_t* seg = &_segments.front(); seg; seg = seg->_next )
+    std::move( seg->_words.begin(), seg->_words.end(), std::back_inserter( _results ) );
+  _segments.clear();
+}
+
+void QuerySession_c::clearResults()
+{
+  std::lock_guard< std::mutex > guard( _accessResults );
+  _results.clear();
+  _segments.clear();
+  _resultsComplete = false;
+}
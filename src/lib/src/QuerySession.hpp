@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "include/TrieNode.hpp"
+
+class Trie_c;
+
+/*!
+  Output buffer of one traversal task. Segments form a singly linked list in
+  lexicographic order; a task only ever writes its own segment and links new
+  segments behind it, so collecting results takes no lock.
+  */
+struct ResultSegment_t
+{
+  std::vector< std::string > _words;
+  ResultSegment_t* _next = nullptr;
+};
+
+// what QueryHandle_c::get() throws for a cancelled query
+class QueryCancelled_c : public std::runtime_error
+{
+public:
+  QueryCancelled_c() : std::runtime_error( "query cancelled" ) {}
+};
+
+/*!
+  Completion state of one query, shared by the session running it and the
+  handles given out for it.
+  */
+struct QueryState_t
+{
+  // Completes the query with 'results', or as cancelled if null, and
+  // returns the continuation of an awaiting coroutine. The caller runs it
+  // once it holds no lock and is done with the session, as the coroutine
+  // may query or destroy it. Only the first call has an effect.
+  std::function< void() > complete( const std::vector< std::string >* results );
+  // registers 'resume' to run on completion, false if already completed
+  bool suspend( std::function< void() > resume );
+
+  std::promise< std::vector< std::string > > _promise;
+  std::shared_future< std::vector< std::string > > _future = _promise.get_future().share();
+  std::atomic< bool > _cancelled{ false };
+  std::mutex _access;
+  bool _done = false;
+  std::function< void() > _continuation;
+};
+
+/*!
+  Result of an asynchronous prefix query. Callers can block on it (get,
+  wait), poll it (ready), cancel it, or co_await it: await_suspend takes any
+  coroutine handle type, so the handle is an awaitable for C++20 coroutines
+  while the library itself stays C++17. The awaiting coroutine is resumed on
+  the thread that completes the query, after the session finished with it:
+  like a callback it may start the next query of the same session, or
+  destroy the session.
+  */
+class QueryHandle_c
+{
+public:
+  explicit QueryHandle_c( std::shared_ptr< QueryState_t > state ) :
+    _state( std::move( state ) ), _future( _state->_future )
+  {
+  }
+
+  // the matches in lexicographic order, throws QueryCancelled_c
+  std::vector< std::string > get() const { return _future.get(); }
+  void wait() const { _future.wait(); }
+  bool ready() const
+  {
+    return _future.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+  }
+  std::shared_future< std::vector< std::string > > future() const { return _future; }
+
+  // Asks the query to stop, without waiting for it. Its tasks give up at the
+  // next node and the handle completes as cancelled, unless it completed
+  // already. Safe to call from any thread, also after the session is gone.
+  void cancel() const { _state->_cancelled = true; }
+
+  bool await_ready() const { return ready(); }
+  template < class Handle >
+  bool await_suspend( Handle coroutine ) const
+  {
+    return _state->suspend( [ coroutine ]() mutable { coroutine.resume(); } );
+  }
+  std::vector< std::string > await_resume() const { return get(); }
+
+private:
+  std::shared_ptr< QueryState_t > _state;
+  std::shared_future< std::vector< std::string > > _future;
+};
+
+/*!
+  State of the prefix queries of one client against a shared Trie_c.
+  The trie is only read, so any number of sessions may query it at the same
+  time, each from its own thread; their traversal tasks share the trie's
+  thread pool. A session runs one query at a time, a new query cancels the
+  previous one.
+  Consecutive queries are incremental, as produced by typing: if the new
+  prefix extends the last one, its matches are filtered out of the previous
+  result, and the descent resumes from the node cached for the longest
+  common prefix, so backspace costs nothing either.
+  Sessions must be destroyed before their trie, and the trie
+  must not be modified while any of them has a query running.
+  */
+class QuerySession_c
+{
+public:
+  using callback = std::function< void( const std::vector< std::string >& ) >;
+
+  explicit QuerySession_c( const Trie_c& trie );
+  QuerySession_c( const QuerySession_c& ) = delete;
+  // cancels the running query
+  ~QuerySession_c();
+
+  // Collects all words starting with the prefix, in lexicographic order, and
+  // hands them to the callback, possibly from a worker thread. The returned
+  // handle completes at the same time; for a trie without workers both
+  // happen before this returns. The callback may start the next query.
+  QueryHandle_c findPrefixMatches( const std::string& prefix );
+
+  // Cancels the running query, if any, and waits until its last task is gone.
+  // Its callback is not called, its handle completes as cancelled.
+  void cancel();
+
+  std::vector< std::string > requestResult() const;
+
+  void setCallback( const callback& cb );
+
+private:
+  NodeIndex_t resume( const std::string& prefix, std::string& path );
+  bool narrowResults( const std::string& prefix );
+
+  void traverse( NodeIndex_t, std::string& path, ResultSegment_t*&, uint64_t epoch );
+  void spawnTraversal( NodeIndex_t, const std::string&, ResultSegment_t*, uint64_t epoch );
+  void finishTask( uint64_t epoch );
+  // cancels like cancel(), but returns the continuation of the cancelled
+  // query instead of running it
+  std::function< void() > stop();
+  bool cancelled( uint64_t epoch ) const
+  {
+    return _epoch.load( std::memory_order_relaxed ) != epoch
+      || _state->_cancelled.load( std::memory_order_relaxed );
+  }
+  // completes the running query with _results on the calling thread, runs
+  // its continuation and calls the callback
+  void deliver();
+
+  ResultSegment_t* newSegment();
+  void mergeResults();
+  void clearResults();
+
+  // subtrees with fewer words are not worth a task of their own
+  static constexpr uint32_t kMinTaskWords = 256;
+
+  const Trie_c& _trie;
+
+  // Every query runs under its own epoch. Bumping the epoch cancels the
+  // running query: its tasks stop at the next node they visit and its
+  // callback is not called.
+  std::atomic< uint64_t > _epoch{ 0 };
+  // traversal tasks of the running query that did not finish yet
+  std::atomic< size_t > _pendingTasks{ 0 };
+  // set while a query has tasks in flight, cleared by its last task
+  bool _queryRunning = false;
+  std::mutex _accessQuery;
+  std::condition_variable _queryDone;
+  // completion of the current query, handed out through QueryHandle_c
+  std::shared_ptr< QueryState_t > _state = std::make_shared< QueryState_t >();
+
+  mutable std::mutex _accessResults;
+  std::vector< std::string > _results;
+  // per-task buffers of the running query, _segments.front() is the head
+  std::mutex _accessSegments;
+  std::deque< ResultSegment_t > _segments;
+
+  // The last prefix and the descent along it: _steps[ i ] is where the first
+  // i bytes lead, a node and how many bytes of its edge label were matched.
+  // _resultsComplete is set when _results hold all matches of _prefix.
+  struct Step_t
+  {
+    NodeIndex_t _node;
+    uint32_t _offset;
+  };
+  std::string _prefix;
+  std::vector< Step_t > _steps;
+  bool _resultsComplete = false;
+  // Trie_c::_version the cache was built for
+  uint64_t _trieVersion = 0;
+
+  callback onFinnishedSearch = []( const std::vector< std::string >& ) {};
+};
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "ShardedTrie.hpp"
+
+struct ShardedTrie_c::Reply_t
+{
+  // one answer per shard asked, in shard order
+  std::vector< std::vector< std::string > > _matches;
+  std::vector< size_t > _counts;
+  std::atomic< size_t > _remaining{ 0 };
+  std::function< void( Reply_t& ) > _complete;
+};
+
+ShardedTrie_c::ShardedTrie_c( const std::vector< std::string > & words, size_t numShards )
+{
+  numShards = std::clamp< size_t >( numShards, 1, 256 );
+
+  // cut the byte range where the running word count passes a multiple of
+  // words / numShards, so every shard gets a contiguous range of about
+  // the same size
+  size_t histogram[ 256 ] = {};
+  for ( const auto& word : words )
+    ++histogram[ word.empty() ? 0 : static_cast< uint8_t >( word.front() ) ];
+  const size_t total = std::max< size_t >( words.size(), 1 );
+  size_t before = 0;
+  for ( size_t byte = 0; byte < 256; ++byte )
+  {
+    _shardOf[ byte ] = static_cast< uint8_t >( std::min( numShards - 1, before * numShards / total ) );
+    before += histogram[ byte ];
+  }
+
+  std::vector< std::vector< std::string > > parts( numShards );
+  for ( const auto& word : words )
+    parts[ _shardOf[ word.empty() ? 0 : static_cast< uint8_t >( word.front() ) ] ].push_back( word );
+
+  for ( size_t i = 0; i < numShards; ++i )
+    _shards.push_back( std::make_unique< Shard_t >() );
+  for ( size_t i = 0; i < numShards; ++i )
+    _shards[ i ]->_thread = std::thread( &ShardedTrie_c::run, this, i, std::move( parts[ i ] ) );
+
+  std::unique_lock< std::mutex > lock( _access );
+  _built.wait( lock, [ & ] { return _numBuilt == _shards.size(); } );
+}
+
+ShardedTrie_c::~ShardedTrie_c()
+{
+  for ( auto& shard : _shards )
+    post( *shard, new Message_t );
+  for ( auto& shard : _shards )
+    shard->_thread.join();
+}
+
+void ShardedTrie_c::findPrefixMatches( const std::string & prefix, callback done )
+{
+  ask( Request_t::Find, prefix, [ done = std::move( done ) ]( Reply_t& reply )
+  {
+    if ( reply._matches.size() == 1 )
+    {
+      done( reply._matches.front() );
+      return;
+    }
+
+    size_t total = 0;
+    for ( const auto& part : reply._matches )
+      total += part.size();
+    std::vector< std::string > all;
+    all.reserve( total );
+    for ( auto& part : reply._matches )
+      std::move( part.begin(), part.end(), std::back_inserter( all ) );
+    done( all );
+  } );
+}
+
+size_t ShardedTrie_c::countPrefixMatches( const std::string & prefix )
+{
+  auto count = std::make_shared< std::promise< size_t > >();
+  std::future< size_t > result = count->get_future();
+  ask( Request_t::Count, prefix, [ count ]( Reply_t& reply )
+  {
+    size_t total = 0;
+    for ( const size_t part : reply._counts )
+      total += part;
+    count->set_value( total );
+  } );
+  return result.get();
+}
+
+void ShardedTrie_c::ask( Request_t request, const std::string & prefix,
+    std::function< void( Reply_t& ) > complete )
+{
+  size_t first = 0;
+  size_t count = _shards.size();
+  if ( !prefix.empty() )
+  {
+    first = _shardOf[ static_cast< uint8_t >( prefix.front() ) ];
+    count = 1;
+  }
+
+  auto reply = std::make_shared< Reply_t >();
+  reply->_matches.resize( count );
+  reply->_counts.resize( count );
+  reply->_remaining = count;
+  reply->_complete = std::move( complete );
+
+  for ( size_t i = 0; i < count; ++i )
+  {
+    auto* message = new Message_t;
+    message->_request = request;
+    message->_prefix = prefix;
+    message->_reply = reply;
+    message->_slot = i;
+    post( *_shards[ first + i ], message );
+  }
+}
+
+void ShardedTrie_c::post( Shard_t & shard, Message_t * message )
+{
+  shard._mailbox.push( message );
+  if ( shard._sleeping )
+  {
+    // pass through the lock so the shard cannot miss the wake-up between
+    // testing its mailbox and going to sleep
+    { std::lock_guard< std::mutex > guard( shard._sleep ); }
+    shard._wakeUp.notify_one();
+  }
+}
+
+/*!
+  Body of a shard thread: builds the shard's trie, so its memory is first
+  touched (and placed) by the core that will serve it, then answers messages
+  until it receives Request_t::Stop.
+  */
+void ShardedTrie_c::run( size_t index, std::vector< std::string > words )
+{
+  Shard_t& shard = *_shards[ index ];
+
+#ifdef __linux__
+  if ( const unsigned cores = std::thread::hardware_concurrency() )
+  {
+    cpu_set_t cpus;
+    CPU_ZERO( &cpus );
+    CPU_SET( index % cores, &cpus );
+    pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus );
+  }
+#endif
+
+  shard._trie = std::make_unique< Trie_c >( kSynchronous, TrieLayout_t::Radix );
+  for ( const auto& word : words )
+    shard._trie->insertWord( word );
+  words = std::vector< std::string >();
+  {
+    std::lock_guard< std::mutex > guard( _access );
+    ++_numBuilt;
+  }
+  _built.notify_one();
+
+  for ( ;; )
+  {
+    Message_t* message = shard._mailbox.pop();
+    if ( !message )
+    {
+      if ( !shard._mailbox.empty() )
+      {
+        // a producer is half way through its push
+        std::this_thread::yield();
+        continue;
+      }
+      shard._sleeping = true;
+      {
+        std::unique_lock< std::mutex > lock( shard._sleep );
+        shard._wakeUp.wait( lock, [ & ] { return !shard._mailbox.empty(); } );
+      }
+      shard._sleeping = false;
+      continue;
+    }
+
+    const bool stop = message->_request == Request_t::Stop;
+    if ( !stop )
+      answer( shard, *message );
+    delete message;
+    if ( stop )
+      return;
+  }
+}
+
+void ShardedTrie_c::answer( Shard_t & shard, Message_t & message )
+{
+  Reply_t& reply = *message._reply;
+  if ( message._request == Request_t::Find )
+    shard._trie->collectPrefixMatches( message._prefix, reply._matches[ message._slot ] );
+  else
+    reply._counts[ message._slot ] = shard._trie->countPrefixMatches( message._prefix );
+
+  // the last shard to answer completes the reply
+  if ( --reply._remaining == 0 )
+    reply._complete( reply );
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Trie.hpp"
+#include "include/MpscQueue.hpp"
+
+/*!
+  Shared-nothing alternative to a Trie_c queried through sessions. The words
+  are partitioned by their first byte into contiguous byte ranges holding
+  about the same number of words, and every shard is a Trie_c built and
+  owned by one thread, pinned to its own core; the shard answers on that
+  thread, so its trie has no worker pool of its own. Nothing of a shard is ever
+  touched by another thread: queries are posted as messages into the shard's
+  lock-free mailbox and the answers travel back in a reply that the last
+  shard to answer completes.
+  A non-empty prefix goes to the single shard owning its first byte, the
+  empty prefix to all of them. As the byte ranges are ordered, concatenating
+  the answers in shard order keeps the result sorted.
+  */
+class ShardedTrie_c
+{
+public:
+  using callback = std::function< void( const std::vector< std::string >& ) >;
+
+  // Builds the shards in parallel, each on its own thread, and returns once
+  // all of them are ready.
+  ShardedTrie_c( const std::vector< std::string >& words, size_t numShards );
+  ShardedTrie_c( const ShardedTrie_c& ) = delete;
+  // stops the shard threads after they answered everything already posted
+  ~ShardedTrie_c();
+
+  // Collects all words starting with the prefix, in lexicographic order.
+  // 'done' is called on a shard thread. May be called from any thread.
+  void findPrefixMatches( const std::string& prefix, callback done );
+
+  // blocks until the owning shards answered
+  size_t countPrefixMatches( const std::string& prefix );
+
+  size_t shardCount() const { return _shards.size(); }
+
+private:
+  struct Reply_t;
+  enum class Request_t : uint8_t { Find, Count, Stop };
+
+  struct Message_t
+  {
+    std::atomic< Message_t* > _next{ nullptr };
+    Request_t _request = Request_t::Stop;
+    std::string _prefix;
+    std::shared_ptr< Reply_t > _reply;
+    // where in the reply this shard's answer goes
+    size_t _slot = 0;
+  };
+
+  // cache line aligned, shards never share a line
+  struct alignas( 64 ) Shard_t
+  {
+    MpscQueue_c< Message_t > _mailbox;
+    std::atomic< bool > _sleeping{ false };
+    std::mutex _sleep;
+    std::condition_variable _wakeUp;
+    std::unique_ptr< Trie_c > _trie;
+    std::thread _thread;
+  };
+
+  void run( size_t index, std::vector< std::string > words );
+  void answer( Shard_t& shard, Message_t& message );
+  void post( Shard_t& shard, Message_t* message );
+  // posts the query to the shards owning the prefix, 'complete' is called
+  // once all of them answered
+  void ask( Request_t request, const std::string& prefix,
+      std::function< void( Reply_t& ) > complete );
+
+  std::vector< std::unique_ptr< Shard_t > > _shards;
+  // shard owning the words starting with a byte, the empty word goes to 0
+  uint8_t _shardOf[ 256 ] = {};
+
+  std::mutex _access;
+  std::condition_variable _built;
+  size_t _numBuilt = 0;
+};
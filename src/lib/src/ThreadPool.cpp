@@ -0,0 +1,155 @@
+#include <exception>
+#include <utility>
+
+#include "ThreadPool.hpp"
+
+namespace
+{
+  // lets submit() recognize calls from inside a worker
+  thread_local const ThreadPool_c* tl_pool = nullptr;
+  thread_local size_t tl_workerIndex = 0;
+}
+
+ThreadPool_c::ThreadPool_c( size_t numWorkers )
+{
+  if ( numWorkers == 0 )
+    numWorkers = 1;
+
+  for ( size_t i = 0; i < numWorkers; ++i )
+    _workers.push_back( std::make_unique< Worker_t >() );
+  // start only once all deques exist, workers steal from each other
+  for ( size_t i = 0; i < numWorkers; ++i )
+    _workers[ i ]->_thread = std::thread( &ThreadPool_c::run, this, i );
+}
+
+ThreadPool_c::~ThreadPool_c()
+{
+  {
+    std::lock_guard< std::mutex > guard( _sleep );
+    _shutdown = true;
+  }
+  _wakeUp.notify_all();
+
+  for ( auto& worker : _workers )
+    worker->_thread.join();
+}
+
+void ThreadPool_c::submit( task t )
+{
+  const size_t index = tl_pool == this
+    ? tl_workerIndex : _nextWorker++ % _workers.size();
+  // count first, so _queued never drops below the number of queued tasks
+  ++_queued;
+  {
+    std::lock_guard< std::mutex > guard( _workers[ index ]->_access );
+    _workers[ index ]->_tasks.push_back( std::move( t ) );
+  }
+
+  if ( _sleeping > 0 )
+  {
+    // pass through the lock so a worker cannot miss the wake-up between
+    // testing its predicate and going to sleep
+    { std::lock_guard< std::mutex > guard( _sleep ); }
+    _wakeUp.notify_one();
+  }
+}
+
+void ThreadPool_c::forEach( size_t count, const std::function< void( size_t ) > & body )
+{
+  std::mutex access;
+  std::exception_ptr failure;
+  // a throwing body must not leave tasks behind that still use our locals:
+  // keep the first exception and let the others finish
+  const auto run = [ & ]( size_t i )
+  {
+    try
+    {
+      body( i );
+    }
+    catch ( ... )
+    {
+      std::lock_guard< std::mutex > guard( access );
+      if ( !failure )
+        failure = std::current_exception();
+    }
+  };
+
+  if ( count < 2 || onWorker() )
+  {
+    for ( size_t i = 0; i < count; ++i )
+      run( i );
+  }
+  else
+  {
+    std::condition_variable finished;
+    size_t pending = count - 1;
+    for ( size_t i = 1; i < count; ++i )
+      submit( [ &, i ]
+      {
+        run( i );
+        std::lock_guard< std::mutex > guard( access );
+        if ( --pending == 0 )
+          finished.notify_one();
+      } );
+    run( 0 );
+
+    std::unique_lock< std::mutex > lock( access );
+    finished.wait( lock, [ & ] { return pending == 0; } );
+  }
+
+  if ( failure )
+    std::rethrow_exception( failure );
+}
+
+bool ThreadPool_c::onWorker() const { return tl_pool == this; }
+
+bool ThreadPool_c::popLocal( size_t index, task& t )
+{
+  Worker_t& worker = *_workers[ index ];
+  std::lock_guard< std::mutex > guard( worker._access );
+  if ( worker._tasks.empty() )
+    return false;
+  t = std::move( worker._tasks.back() );
+  worker._tasks.pop_back();
+  return true;
+}
+
+bool ThreadPool_c::steal( size_t thief, task& t )
+{
+  for ( size_t i = 1; i < _workers.size(); ++i )
+  {
+    Worker_t& victim = *_workers[ ( thief + i ) % _workers.size() ];
+    std::lock_guard< std::mutex > guard( victim._access );
+    if ( victim._tasks.empty() )
+      continue;
+    t = std::move( victim._tasks.front() );
+    victim._tasks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool_c::run( size_t index )
+{
+  tl_pool = this;
+  tl_workerIndex = index;
+
+  task t;
+  while ( true )
+  {
+    if ( popLocal( index, t ) || steal( index, t ) )
+    {
+      --_queued;
+      t();
+      t = nullptr;
+      continue;
+    }
+
+    std::unique_lock< std::mutex > lock( _sleep );
+    ++_sleeping;
+    _wakeUp.wait( lock, [ this ] { return _queued > 0 || _shutdown; } );
+    --_sleeping;
+    if ( _shutdown )
+      return;
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+  Fixed set of long-lived worker threads with one task deque per worker.
+  A worker pushes and pops tasks at the back of its own deque (depth-first,
+  cache friendly) and, when that runs dry, steals from the front of the
+  others (the oldest, usually largest tasks). Idle workers sleep on a
+  condition variable instead of spinning.
+  */
+class ThreadPool_c
+{
+public:
+  using task = std::function< void() >;
+
+  explicit ThreadPool_c( size_t numWorkers );
+  ThreadPool_c( const ThreadPool_c& ) = delete;
+  // stops the workers, tasks that did not start yet are dropped
+  ~ThreadPool_c();
+
+  // called from one of our workers the task goes to that worker's deque,
+  // otherwise the deques are filled round robin
+  void submit( task t );
+
+  /*!
+    Runs body( 0 ) .. body( count - 1 ) on the workers and the calling
+    thread and returns when all of them are done. Called from one of our
+    own workers it runs them all inline instead: waiting there for tasks
+    queued behind the caller could wait forever. Bodies that throw do not
+    stop the others; once all are done the first exception is rethrown.
+    */
+  void forEach( size_t count, const std::function< void( size_t ) >& body );
+
+  // true on one of our worker threads
+  bool onWorker() const;
+
+  size_t size() const { return _workers.size(); }
+
+private:
+  struct Worker_t
+  {
+    std::mutex _access;
+    std::deque< task > _tasks;
+    std::thread _thread;
+  };
+
+  void run( size_t index );
+  bool popLocal( size_t index, task& t );
+  bool steal( size_t thief, task& t );
+
+  std::vector< std::unique_ptr< Worker_t > > _workers;
+
+  std::mutex _sleep;
+  std::condition_variable _wakeUp;
+  std::atomic< size_t > _queued{ 0 };
+  std::atomic< size_t > _sleeping{ 0 };
+  std::atomic< size_t > _nextWorker{ 0 };
+  std::atomic< bool > _shutdown{ false };
+};
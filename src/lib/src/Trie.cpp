@@ -1,173 +1,818 @@
-#include <chrono>
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
 #include <string>
 
+#include "Dawg.hpp"
+#include "DoubleArrayTrie.hpp"
+#include "GlobPattern.hpp"
+#include "LoudsTrie.hpp"
 #include "Trie.hpp"
+#include "TrieImage.hpp"
 
-Trie_c::Trie_c( size_t num ) : _numWorkers( num )
+namespace
 {
-  _root = std::make_unique< TrieNode_t >();
-  if ( _numWorkers == 0 )
-    _numWorkers = 1;
+  void collect( const NodeArena_c& arena, NodeIndex_t node, std::string& path,
+      std::vector< std::string >& out )
+  {
+    if ( arena[ node ]._isLeaf )
+      out.push_back( path );
 
-  _workers.resize( _numWorkers );
+    arena.forEachChild( node, [ & ]( NodeIndex_t child )
+    {
+      const size_t length = path.size();
+      path.append( arena.label( child ) );
+      collect( arena, child, path, out );
+      path.resize( length );
+    } );
+  }
 
-  // _idleWorkers is a deque so as to avoid vector<bool>
-  for ( size_t i = 0; i < _numWorkers; ++i )
+  /*!
+    Walks below 'node' while extending a Levenshtein DP table by one row per
+    byte: row entry i is the edit distance between the path and the first i
+    bytes of 'prefix'. 'rows' holds the rows of the whole path back to back.
+    Once the last entry is within 'maxEdits' the entire subtree matches; once
+    no entry is, nothing below can match any more.
+    */
+  void collectFuzzy( const NodeArena_c& arena, NodeIndex_t node, std::string& path,
+      std::string_view prefix, uint32_t maxEdits, std::vector< uint32_t >& rows,
+      std::vector< std::string >& out )
   {
-    //_idleWorkers.push_back( true );
-    _idleWorkers.push_back( i );
-    _workers[ i ] = std::thread();
+    const size_t width = prefix.size() + 1;
+    arena.forEachChild( node, [ & ]( NodeIndex_t child )
+    {
+      const size_t length = path.size();
+      const size_t numRows = rows.size();
+      bool matches = false;
+      bool hopeless = false;
+      for ( const char letter : arena.label( child ) )
+      {
+        rows.resize( rows.size() + width );
+        const uint32_t* above = rows.data() + rows.size() - 2 * width;
+        uint32_t* row = rows.data() + rows.size() - width;
+
+        row[ 0 ] = above[ 0 ] + 1;
+        uint32_t best = row[ 0 ];
+        for ( size_t i = 1; i < width; ++i )
+        {
+          const uint32_t substitute = above[ i - 1 ] + ( prefix[ i - 1 ] != letter );
+          row[ i ] = std::min( { above[ i ] + 1, row[ i - 1 ] + 1, substitute } );
+          best = std::min( best, row[ i ] );
+        }
+        matches = row[ width - 1 ] <= maxEdits;
+        hopeless = best > maxEdits;
+        if ( matches || hopeless )
+          break;
+      }
+
+      path.append( arena.label( child ) );
+      if ( matches )
+        collect( arena, child, path, out );
+      else if ( !hopeless )
+        collectFuzzy( arena, child, path, prefix, maxEdits, rows, out );
+      path.resize( length );
+      rows.resize( numRows );
+    } );
   }
-}
 
-Trie_c::~Trie_c() = default;
+  /*!
+    Walks below 'node', whose path left 'pattern' in 'state'. A child is
+    entered only if its edge label keeps some NFA state alive, and when the
+    pattern allows a single byte next, the child is looked up directly
+    instead of visiting all of them. Once the pattern ends in an active '*',
+    the whole subtree matches.
+    */
+  void collectPattern( const NodeArena_c& arena, NodeIndex_t node, std::string& path,
+      const GlobPattern_c& pattern, GlobPattern_c::State_t state, std::vector< std::string >& out )
+  {
+    if ( arena[ node ]._isLeaf && pattern.accepts( state ) )
+      out.push_back( path );
 
-void Trie_c::insertWord( const std::string & word )
-{
-  TrieNode_t* nodePtr = _root.get();
+    const auto enter = [ & ]( NodeIndex_t child )
+    {
+      const GlobPattern_c::State_t next = pattern.step( state, arena.label( child ) );
+      if ( !next )
+        return;
+      const size_t length = path.size();
+      path.append( arena.label( child ) );
+      if ( pattern.acceptsAnySuffix( next ) )
+        collect( arena, child, path, out );
+      else
+        collectPattern( arena, child, path, pattern, next, out );
+      path.resize( length );
+    };
 
-  for ( const char letter : word )
+    char letter;
+    if ( pattern.onlyByte( state, letter ) )
+    {
+      const NodeIndex_t child = arena.findChild( node, letter );
+      if ( child != kNullNode )
+        enter( child );
+    }
+    else
+      arena.forEachChild( node, enter );
+  }
+
+  // depth-first order is lexicographic order, exactly what the DAWG needs
+  void feedSorted( const NodeArena_c& arena, NodeIndex_t node, std::string& path,
+      DawgBuilder_c& builder )
   {
-    if ( !nodePtr->_children.count( letter ) )
-      nodePtr->_children[ letter ] = new TrieNode_t();
+    if ( arena[ node ]._isLeaf )
+      builder.insertSorted( path );
 
-    // point to new child node
-    nodePtr = nodePtr->_children[ letter ];
+    arena.forEachChild( node, [ & ]( NodeIndex_t child )
+    {
+      const size_t length = path.size();
+      path.append( arena.label( child ) );
+      feedSorted( arena, child, path, builder );
+      path.resize( length );
+    } );
   }
-  nodePtr->_isLeaf = true;
+}
+
+Trie_c::Trie_c( size_t num, TrieLayout_t layout ) :
+  _layout( layout ), _numWorkers( std::max< size_t >( 1, num ) ),
+  _pool( std::make_unique< ThreadPool_c >( _numWorkers ) ),
+  _defaultSession( *this )
+{
+}
+
+Trie_c::Trie_c( Synchronous_t, TrieLayout_t layout ) :
+  _layout( layout ), _numWorkers( 0 ),
+  _defaultSession( *this )
+{
+}
+
+void Trie_c::insertWord( std::string_view word, uint32_t weight )
+{
+  if ( _frozen )
+    throw std::logic_error( "Trie_c: cannot insert into a frozen trie" );
+
+  ++_version;
+  insertInto( _arena, _layout, word, weight, _insertPath );
 }
 
 /*!
-  Private helper function to perform depth-first traversal, a.k.a pre-order traversal
-  Given the root of the sub-trie under prefix, traverse all nodes in depth-first order
-  to reach the leaves
+  Inserts 'word' into 'arena' and updates word counts and maximum weights
+  along its path. 'path' is scratch space, passed in to keep its capacity.
   */
-void Trie_c::traverse( const TrieNode_t * rootSubT, const std::string & word,
-    size_t workerIndex )
+void Trie_c::insertInto( NodeArena_c & arena, TrieLayout_t layout,
+    std::string_view word, uint32_t weight, std::vector< NodeIndex_t > & path )
+{
+  path.clear();
+  const NodeIndex_t node = layout == TrieLayout_t::Radix
+    ? insertPathRadix( arena, word, path ) : insertPathPlain( arena, word, path );
+
+  const bool isNew = !arena[ node ]._isLeaf;
+  arena[ node ]._isLeaf = true;
+  arena[ node ]._weight = std::max( arena[ node ]._weight, weight );
+
+  // every node on the path gains the word and possibly a new maximum
+  path.push_back( arena.root() );
+  for ( const NodeIndex_t onPath : path )
+  {
+    TrieNode_t& n = arena[ onPath ];
+    n._wordCount += isNew;
+    n._maxWeight = std::max( n._maxWeight, weight );
+  }
+}
+
+void Trie_c::insertWords( const std::vector< WordEntry_t > & words )
+{
+  if ( _frozen )
+    throw std::logic_error( "Trie_c: cannot insert into a frozen trie" );
+
+  // subtries can only be stitched under a root that has no children yet
+  if ( _arena.size() > 1 || _numWorkers < 2 )
+  {
+    for ( const auto& word : words )
+      insertWord( word._word, word._weight );
+    return;
+  }
+
+  ++_version;
+  std::vector< const WordEntry_t* > byFirstByte[ 256 ];
+  for ( const auto& word : words )
+    if ( !word._word.empty() )
+      byFirstByte[ static_cast< uint8_t >( word._word.front() ) ].push_back( &word );
+
+  // one subtrie per first byte, built by the workers
+  std::vector< size_t > bytes;
+  for ( size_t byte = 0; byte < 256; ++byte )
+    if ( !byFirstByte[ byte ].empty() )
+      bytes.push_back( byte );
+  std::unique_ptr< NodeArena_c > subtries[ 256 ];
+  _pool->forEach( bytes.size(), [ & ]( size_t i )
+  {
+    auto subtrie = std::make_unique< NodeArena_c >();
+    std::vector< NodeIndex_t > path;
+    for ( const WordEntry_t* word : byFirstByte[ bytes[ i ] ] )
+      insertInto( *subtrie, _layout, word->_word, word->_weight, path );
+    subtries[ bytes[ i ] ] = std::move( subtrie );
+  } );
+
+  // stitch them under the root, each one starts with a different byte
+  size_t numNodes = 1;
+  for ( const auto& subtrie : subtries )
+    numNodes += subtrie ? subtrie->size() - 1 : 0;
+  _arena.reserve( numNodes );
+  for ( auto& subtrie : subtries )
+  {
+    if ( !subtrie )
+      continue;
+    _arena.graft( *subtrie );
+    subtrie.reset();
+  }
+
+  // the empty word ends at the root
+  for ( const auto& word : words )
+    if ( word._word.empty() )
+      insertInto( _arena, _layout, word._word, word._weight, _insertPath );
+}
+
+void Trie_c::buildFromSorted( const std::vector< WordEntry_t > & words )
 {
-  if ( rootSubT->_isLeaf )
-    pushBackResult( word );
+  if ( _frozen )
+    throw std::logic_error( "Trie_c: cannot insert into a frozen trie" );
 
-  if ( !rootSubT->_children.empty() )
+  ++_version;
+  auto next = words.begin();
+  if ( _arena.size() == 1 )
   {
-    if ( rootSubT->_children.size() == 1 )  // No need for other threads
+    // the path of the previous word, as nodes and the length of the word
+    // they spell
+    struct Frame_t
     {
-      const std::string temp = word + rootSubT->_children.begin()->first;
-      const auto nodePtr = rootSubT->_children.begin()->second;
-      traverse( nodePtr, temp, workerIndex );
-    }
-    else // Other threads could help, and our paths diverge
+      NodeIndex_t _node;
+      size_t _depth;
+    };
+    std::vector< Frame_t > path{ { _arena.root(), 0 } };
+    std::string_view previous;
+
+    for ( ; next != words.end(); ++next )
     {
-      for ( const auto& [ letter, tnPtr ] : rootSubT->_children )
-      {
-        if ( _stopAllWorkers )
-          break;
+      const std::string_view word = next->_word;
+      if ( word < previous )
+        break;
 
-        const std::string temp = word + letter;
-        size_t newCandidateWorkerId;
-        if ( reserveFreeWorker( newCandidateWorkerId ) )
-        {
-          // The candidate finished executing code yet still active.
-          if ( _workers[ newCandidateWorkerId ].joinable() )
-            _dump.emplace_back( std::move( _workers[ newCandidateWorkerId ] ) );
+      size_t common = 0;
+      while ( common < previous.size() && common < word.size() && previous[ common ] == word[ common ] )
+        ++common;
 
-          _workers[ newCandidateWorkerId ] = std::thread(
-             &Trie_c::startThread, this, tnPtr, temp, newCandidateWorkerId );
-          _workers[ newCandidateWorkerId ].detach();
-        }
-        else
+      // back up to the common prefix, cutting the edge it ends in
+      while ( path.back()._depth > common )
+      {
+        const Frame_t popped = path.back();
+        path.pop_back();
+        if ( path.back()._depth < common )
         {
-          // ok, everyone busy. I will do it myself...
-          traverse( tnPtr, temp, workerIndex );
+          _arena.splitLabel( popped._node, static_cast< uint32_t >( common - path.back()._depth ) );
+          path.push_back( { popped._node, common } );
         }
       }
+
+      // everything behind it is new, and sorts behind all existing children
+      if ( _layout == TrieLayout_t::Radix && common < word.size() )
+      {
+        path.push_back( { _arena.addChild( path.back()._node, word.substr( common ) ), word.size() } );
+      }
+      else
+      {
+        for ( size_t pos = common; pos < word.size(); ++pos )
+          path.push_back( { _arena.addChild( path.back()._node, word.substr( pos, 1 ) ), pos + 1 } );
+      }
+
+      TrieNode_t& leaf = _arena[ path.back()._node ];
+      const bool isNew = !leaf._isLeaf;
+      leaf._isLeaf = true;
+      leaf._weight = std::max( leaf._weight, next->_weight );
+      for ( const Frame_t& frame : path )
+      {
+        TrieNode_t& n = _arena[ frame._node ];
+        n._wordCount += isNew;
+        n._maxWeight = std::max( n._maxWeight, next->_weight );
+      }
+      previous = word;
     }
   }
+
+  // unsorted input, or a trie that was not empty
+  for ( ; next != words.end(); ++next )
+    insertInto( _arena, _layout, next->_word, next->_weight, _insertPath );
 }
 
-void Trie_c::startThread( const TrieNode_t * rootSubT, const std::string & word,
-  size_t workerId )
+NodeIndex_t Trie_c::insertPathPlain( NodeArena_c & arena, std::string_view word,
+    std::vector< NodeIndex_t > & path )
 {
-  traverse( rootSubT, word, workerId );
+  NodeIndex_t node = arena.root();
 
-  std::lock_guard< std::mutex > guard( _accessWorkers );
-  _idleWorkers.push_back( workerId );
+  for ( const char letter : word )
+  {
+    // point to (possibly new) child node
+    node = arena.findOrAddChild( node, letter );
+    path.push_back( node );
+  }
+  return node;
+}
+
+void Trie_c::freeze( FrozenLayout_t layout, bool keepArena )
+{
+  if ( _frozen )
+    return;
 
-  if ( _idleWorkers.size() == _numWorkers )
-    // the last worker calls the callback function
-    onFinnishedSearch( _results );
+  _defaultSession.cancel();
+  if ( layout == FrozenLayout_t::DoubleArray )
+  {
+    _frozen = std::make_unique< DoubleArrayTrie_c >( _arena );
+  }
+  else if ( layout == FrozenLayout_t::WordRanges )
+  {
+    _frozen = std::make_unique< WordRangeTrie_c >( _arena );
+  }
+  else if ( layout == FrozenLayout_t::Dawg )
+  {
+    DawgBuilder_c builder;
+    std::string path;
+    feedSorted( _arena, _arena.root(), path, builder );
+    _frozen = builder.finish();
+  }
+  else
+    _frozen = std::make_unique< LoudsTrie_c >( _arena );
+  if ( !keepArena )
+  {
+    _arena.clear();
+    _hasArena = false;
+  }
+  ++_version;
 }
 
-void Trie_c::setCallback( const callback & cb ) { onFinnishedSearch = cb; }
+void Trie_c::save( const std::string & path ) const
+{
+  if ( const auto* doubleArray = dynamic_cast< const DoubleArrayTrie_c* >( _frozen.get() ) )
+  {
+    TrieImage_c::save( *doubleArray, path );
+    return;
+  }
 
-std::vector<std::string> Trie_c::requestResult() const {
-    std::lock_guard< std::mutex > guard( _accessResults );
-    return _results;
+  if ( !_hasArena )
+    throw std::logic_error( "Trie_c: only double-array tries can be saved" );
+  TrieImage_c::save( DoubleArrayTrie_c( _arena ), path );
+}
+
+void Trie_c::open( const std::string & path, bool verifyChecksum )
+{
+  auto image = TrieImage_c::open( path, verifyChecksum );
+
+  _defaultSession.cancel();
+  _frozen = std::move( image );
+  _arena.clear();
+  _hasArena = false;
+  ++_version;
+}
+
+WordRangeView_c Trie_c::prefixRange( const std::string & prefix ) const
+{
+  const auto* ranges = dynamic_cast< const WordRangeTrie_c* >( _frozen.get() );
+  if ( !ranges )
+    throw std::logic_error( "Trie_c: prefixRange needs FrozenLayout_t::WordRanges" );
+  return ranges->prefixRange( prefix );
+}
+
+size_t Trie_c::countPrefixMatches( const std::string & prefix ) const
+{
+  if ( _frozen )
+    return _frozen->countPrefixMatches( prefix );
+
+  std::string path;
+  const NodeIndex_t node = descend( prefix, path );
+  return node == kNullNode ? 0 : _arena[ node ]._wordCount;
+}
+
+std::vector< ScoredWord_t > Trie_c::topK( const std::string & prefix, size_t k ) const
+{
+  if ( !_hasArena )
+    throw std::logic_error( "Trie_c: topK needs the node arena" );
+
+  std::vector< ScoredWord_t > result;
+  std::string path;
+  const NodeIndex_t start = descend( prefix, path );
+  if ( start == kNullNode || k == 0 )
+    return result;
+
+  // Best-first search. A candidate is either a whole subtree, ranked by its
+  // maximum weight, or a single word, ranked by its own weight. Since no
+  // subtree holds anything heavier than its bound, words leave the queue in
+  // descending weight order and the search ends after the k-th one.
+  struct Candidate_t
+  {
+    uint32_t _bound;
+    bool _isWord;
+    uint32_t _visit; // index into 'visited'
+  };
+  struct Visited_t
+  {
+    NodeIndex_t _node;
+    uint32_t _parent; // index into 'visited', UINT32_MAX for the start node
+  };
+  const auto lower = []( const Candidate_t& a, const Candidate_t& b )
+  {
+    if ( a._bound != b._bound )
+      return a._bound < b._bound;
+    // words before subtrees of the same bound
+    return !a._isWord && b._isWord;
+  };
+
+  std::vector< Visited_t > visited{ { start, UINT32_MAX } };
+  std::vector< Candidate_t > queue{ { _arena[ start ]._maxWeight, false, 0 } };
+
+  while ( !queue.empty() && result.size() < k )
+  {
+    std::pop_heap( queue.begin(), queue.end(), lower );
+    const Candidate_t best = queue.back();
+    queue.pop_back();
+
+    if ( best._isWord )
+    {
+      // spell the word by walking back up to the start node
+      std::vector< std::string_view > labels;
+      for ( uint32_t v = best._visit; visited[ v ]._parent != UINT32_MAX; v = visited[ v ]._parent )
+        labels.push_back( _arena.label( visited[ v ]._node ) );
+      std::string word = path;
+      for ( auto it = labels.rbegin(); it != labels.rend(); ++it )
+        word.append( *it );
+      result.push_back( { std::move( word ), best._bound } );
+      continue;
+    }
+
+    const NodeIndex_t node = visited[ best._visit ]._node;
+    if ( _arena[ node ]._isLeaf )
+    {
+      queue.push_back( { _arena[ node ]._weight, true, best._visit } );
+      std::push_heap( queue.begin(), queue.end(), lower );
+    }
+    _arena.forEachChild( node, [ & ]( NodeIndex_t child )
+    {
+      visited.push_back( { child, best._visit } );
+      queue.push_back( { _arena[ child ]._maxWeight, false,
+          static_cast< uint32_t >( visited.size() - 1 ) } );
+      std::push_heap( queue.begin(), queue.end(), lower );
+    } );
+
+    // every candidate still holds a word as heavy as its bound, so only the
+    // 'need' best candidates can contribute: keep the queue bounded
+    const size_t need = k - result.size();
+    if ( queue.size() > 2 * need + 16 )
+    {
+      std::nth_element( queue.begin(), queue.begin() + need, queue.end(),
+          [ & ]( const Candidate_t& a, const Candidate_t& b ) { return lower( b, a ); } );
+      queue.resize( need );
+      std::make_heap( queue.begin(), queue.end(), lower );
+    }
+  }
+  return result;
 }
 
-void Trie_c::findPrefixMatches( const std::string & prefix ) {
-    _input = prefix;
-    _reachedNode = _root.get();
+bool Trie_c::containsPrefix( const std::string & prefix ) const
+{
+  if ( _frozen )
+    return _frozen->containsPrefix( prefix );
+
+  std::string path;
+  return descend( prefix, path ) != kNullNode;
+}
+
+std::vector< std::string > Trie_c::findFuzzyPrefixMatches( const std::string & prefix,
+    uint32_t maxEdits ) const
+{
+  if ( !_hasArena )
+    throw std::logic_error( "Trie_c: fuzzy matching needs the node arena" );
+
+  std::vector< std::string > matches;
+  std::string path;
+  // the empty path is prefix.size() deletions away
+  std::vector< uint32_t > rows( prefix.size() + 1 );
+  for ( size_t i = 0; i < rows.size(); ++i )
+    rows[ i ] = static_cast< uint32_t >( i );
+
+  if ( prefix.size() <= maxEdits )
+    collect( _arena, _arena.root(), path, matches );
+  else
+    collectFuzzy( _arena, _arena.root(), path, prefix, maxEdits, rows, matches );
+  return matches;
+}
+
+/*!
+  Descends along the literal prefix of the pattern, then splits the rest of
+  the walk breadth-first into subtrees, kept in lexicographic order, until
+  there are a few per worker. The subtrees are matched concurrently on the
+  worker pool and their results concatenated. Called from one of the pool's
+  own workers, e.g. from a query callback, it matches on that thread alone.
+  */
+std::vector< std::string > Trie_c::findPatternMatches( const std::string & glob ) const
+{
+  if ( !_hasArena )
+    throw std::logic_error( "Trie_c: pattern matching needs the node arena" );
 
-    // todo: we could check whether restart is really necessary.
-    stopAllWorkers();
-    clearResults();
+  const GlobPattern_c pattern( glob );
+  std::string path;
+  const NodeIndex_t start = descend( pattern.literalPrefix(), path );
+  const GlobPattern_c::State_t state = start == kNullNode ? 0 : pattern.step( pattern.start(), path );
+  if ( !state )
+    return {};
 
-    for ( const char letter : prefix )
+  struct Task_t
+  {
+    NodeIndex_t _node;
+    std::string _path;
+    GlobPattern_c::State_t _state;
+    // only the word of _node, its children are tasks of their own
+    bool _wordOnly;
+  };
+  std::vector< Task_t > tasks{ { start, path, state, false } };
+  for ( bool split = _numWorkers > 1 && !_pool->onWorker(); split && tasks.size() < 4 * _numWorkers; )
+  {
+    split = false;
+    std::vector< Task_t > next;
+    for ( auto& task : tasks )
     {
-      if ( !_reachedNode->_children.count( letter ) )
+      if ( task._wordOnly || pattern.acceptsAnySuffix( task._state ) )
       {
-        // Callback: wait for search to finish and print results
-        onFinnishedSearch( _results );
-        return;
+        next.push_back( std::move( task ) );
+        continue;
       }
-      _reachedNode = _reachedNode->_children.at( letter );
+      if ( _arena[ task._node ]._isLeaf && pattern.accepts( task._state ) )
+        next.push_back( { task._node, task._path, task._state, true } );
+      const auto enter = [ & ]( NodeIndex_t child )
+      {
+        const std::string_view label = _arena.label( child );
+        const GlobPattern_c::State_t childState = pattern.step( task._state, label );
+        if ( childState )
+          next.push_back( { child, task._path + std::string( label ), childState, false } );
+      };
+      // a literal comes next: only one child can match
+      char letter;
+      if ( pattern.onlyByte( task._state, letter ) )
+      {
+        const NodeIndex_t child = _arena.findChild( task._node, letter );
+        if ( child != kNullNode )
+          enter( child );
+      }
+      else
+        _arena.forEachChild( task._node, enter );
+      split = true;
     }
+    tasks = std::move( next );
+  }
 
-    size_t index{ 0 };
-    if ( !reserveFreeWorker( index ) )
-      return;
+  const auto run = [ & ]( Task_t& task, std::vector< std::string >& out )
+  {
+    if ( task._wordOnly )
+      out.push_back( task._path );
+    else if ( pattern.acceptsAnySuffix( task._state ) )
+      collect( _arena, task._node, task._path, out );
+    else
+      collectPattern( _arena, task._node, task._path, pattern, task._state, out );
+  };
+
+  std::vector< std::string > matches;
+  if ( tasks.size() == 1 )
+  {
+    run( tasks.front(), matches );
+    return matches;
+  }
+
+  std::vector< std::vector< std::string > > results( tasks.size() );
+  _pool->forEach( tasks.size(), [ & ]( size_t i ) { run( tasks[ i ], results[ i ] ); } );
 
-    _workers[ index ] = std::thread( &Trie_c::startThread, this, _reachedNode,
-        prefix, index );
-    _workers[ index ].detach();
+  for ( auto& result : results )
+    matches.insert( matches.end(), std::make_move_iterator( result.begin() ),
+        std::make_move_iterator( result.end() ) );
+  return matches;
 }
 
-void Trie_c::pushBackResult( const std::string & word ) {
-    std::lock_guard< std::mutex > guard( _accessResults );
-    _results.push_back( word );
+PrefixPage_t Trie_c::findPrefixMatches( const std::string & prefix, size_t limit,
+    size_t offset ) const
+{
+  return findPage( prefix, limit, offset, nullptr );
 }
 
-void Trie_c::clearResults() {
-    std::lock_guard< std::mutex > guard( _accessResults );
-    _results.clear();
-    _dump.clear();
+PrefixPage_t Trie_c::findPrefixMatches( const std::string & prefix, size_t limit,
+    const std::string & continuation ) const
+{
+  return findPage( prefix, limit, 0, &continuation );
 }
 
-bool Trie_c::reserveFreeWorker( size_t & index )
+PrefixPage_t Trie_c::findPage( const std::string & prefix, size_t limit, size_t offset,
+    const std::string * after ) const
 {
-  using namespace std::chrono_literals;
-  std::lock_guard< std::mutex > guard( _accessWorkers );
+  PrefixPage_t page;
+  if ( _frozen )
+  {
+    if ( after )
+      offset = _frozen->countUpTo( prefix, *after );
+    page._more = _frozen->findPage( prefix, offset, limit, page._words );
+    return page;
+  }
+
+  std::string path;
+  const NodeIndex_t start = descend( prefix, path );
+  if ( start == kNullNode )
+    return page;
 
-  if ( _idleWorkers.empty() )
+  if ( after )
   {
-    return false;
+    std::string scratch = path;
+    offset = countUpTo( start, scratch, *after );
   }
-  else
+  size_t skip = offset;
+  collectPage( start, path, skip, limit, page._words );
+  page._more = offset + page._words.size() < _arena[ start ]._wordCount;
+  return page;
+}
+
+/*!
+  Appends the words below 'node' (which spells 'path') to 'out' until it
+  holds 'limit' words, leaving out the first 'skip'. Subtrees that lie
+  completely in front of the page are skipped by their word count.
+  */
+void Trie_c::collectPage( NodeIndex_t node, std::string & path, size_t & skip, size_t limit,
+    std::vector< std::string > & out ) const
+{
+  const TrieNode_t& n = _arena[ node ];
+  if ( out.size() >= limit )
+    return;
+  if ( skip >= n._wordCount )
+  {
+    skip -= n._wordCount;
+    return;
+  }
+
+  if ( n._isLeaf )
   {
-    index = _idleWorkers.front();
-    _idleWorkers.pop_front();
-    return true;
+    if ( skip > 0 )
+      --skip;
+    else
+      out.push_back( path );
   }
-  return false;
+
+  const size_t length = path.size();
+  uint32_t cursor = 0;
+  while ( out.size() < limit )
+  {
+    const NodeIndex_t child = _arena.nextChild( node, cursor );
+    if ( child == kNullNode )
+      break;
+    path.resize( length );
+    path.append( _arena.label( child ) );
+    collectPage( child, path, skip, limit, out );
+  }
+  path.resize( length );
 }
 
-void Trie_c::stopAllWorkers() {
-    _stopAllWorkers = true;
-    while ( _idleWorkers.size() < _numWorkers ) {
-        []() {}();
+/*!
+  Number of words below 'node' (which spells 'path') that are not greater
+  than 'last'. Follows 'last' down a single path and adds up the word counts
+  of the subtrees to its left.
+  */
+size_t Trie_c::countUpTo( NodeIndex_t node, std::string & path, std::string_view last ) const
+{
+  const TrieNode_t& n = _arena[ node ];
+  const size_t common = std::min( path.size(), last.size() );
+  const int order = std::string_view( path ).compare( 0, common, last.substr( 0, common ) );
+  if ( order != 0 )
+    return order < 0 ? n._wordCount : 0;
+  // 'last' is a proper prefix of every word down here
+  if ( path.size() > last.size() )
+    return 0;
+
+  size_t count = n._isLeaf ? 1 : 0;
+  if ( path.size() == last.size() )
+    return count;
+
+  const size_t length = path.size();
+  const auto next = static_cast< uint8_t >( last[ length ] );
+  uint32_t cursor = 0;
+  for ( NodeIndex_t child = _arena.nextChild( node, cursor ); child != kNullNode;
+        child = _arena.nextChild( node, cursor ) )
+  {
+    const auto key = static_cast< uint8_t >( _arena[ child ]._letter );
+    if ( key < next )
+    {
+      count += _arena[ child ]._wordCount;
+      continue;
     }
+    if ( key == next )
+    {
+      path.append( _arena.label( child ) );
+      count += countUpTo( child, path, last );
+    }
+    break;
+  }
+  return count;
+}
+
+PrefixCursor_c Trie_c::cursor( const std::string & prefix ) const
+{
+  if ( !_hasArena )
+    throw std::logic_error( "Trie_c: cursor needs the node arena" );
+
+  std::string path;
+  const NodeIndex_t node = descend( prefix, path );
+  return PrefixCursor_c( _arena, node, std::move( path ) );
+}
+
+void Trie_c::collectPrefixMatches( const std::string & prefix,
+    std::vector< std::string > & out ) const
+{
+  if ( _frozen )
+  {
+    _frozen->findPrefixMatches( prefix, out );
+    return;
+  }
+
+  std::string path;
+  const NodeIndex_t node = descend( prefix, path );
+  if ( node != kNullNode )
+    collect( _arena, node, path, out );
+}
+
+size_t Trie_c::memoryUsage() const
+{
+  return ( _frozen ? _frozen->memoryUsage() : 0 ) + ( _hasArena ? _arena.memoryUsage() : 0 );
+}
 
-    _stopAllWorkers = false;
-}
\ No newline at end of file
+NodeIndex_t Trie_c::insertPathRadix( NodeArena_c & arena, std::string_view word,
+    std::vector< NodeIndex_t > & path )
+{
+  NodeIndex_t node = arena.root();
+  size_t pos = 0;
+
+  while ( pos < word.size() )
+  {
+    const std::string_view rest = word.substr( pos );
+    const NodeIndex_t child = arena.findChild( node, rest.front() );
+    if ( child == kNullNode )
+    {
+      // the remainder of the word becomes a single edge
+      node = arena.addChild( node, rest );
+      path.push_back( node );
+      pos = word.size();
+      break;
+    }
+
+    const std::string_view label = arena.label( child );
+    uint32_t common = 1;
+    while ( common < label.size() && common < rest.size()
+            && label[ common ] == rest[ common ] )
+      ++common;
+
+    // the word leaves the edge half way: cut it there
+    if ( common < label.size() )
+      arena.splitLabel( child, common );
+
+    node = child;
+    path.push_back( node );
+    pos += common;
+  }
+  return node;
+}
+
+/*!
+  Walks down from the root along 'prefix'. Returns the node whose subtree holds
+  all matches, or kNullNode. 'path' receives the word spelled by that node,
+  which is longer than the prefix if the prefix ends inside a radix edge.
+  */
+NodeIndex_t Trie_c::descend( const std::string & prefix, std::string & path ) const
+{
+  NodeIndex_t node = _arena.root();
+  path = prefix;
+  size_t pos = 0;
+
+  while ( pos < prefix.size() )
+  {
+    node = _arena.findChild( node, prefix[ pos ] );
+    if ( node == kNullNode )
+      return kNullNode;
+
+    const std::string_view label = _arena.label( node );
+    const size_t n = std::min( label.size(), prefix.size() - pos );
+    if ( label.compare( 0, n, std::string_view( prefix ).substr( pos, n ) ) != 0 )
+      return kNullNode;
+
+    if ( n < label.size() )
+      path.append( label.substr( n ) );
+    pos += n;
+  }
+  return node;
+}
+
+void Trie_c::setCallback( const callback & cb ) { _defaultSession.setCallback( cb ); }
+
+std::vector<std::string> Trie_c::requestResult() const {
+    return _defaultSession.requestResult();
+}
+
+QueryHandle_c Trie_c::findPrefixMatches( const std::string & prefix ) {
+    return _defaultSession.findPrefixMatches( prefix );
+}
@@ -1,56 +1,237 @@
 #pragma once
 
-#include <functional>
 #include <memory>
-#include <mutex>
 #include <string>
-#include <thread>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
-#include <deque>
-#include "include/TrieNode.hpp"
+#include "FrozenTrie.hpp"
+#include "PrefixCursor.hpp"
+#include "QuerySession.hpp"
+#include "ThreadPool.hpp"
+#include "WordRangeTrie.hpp"
+#include "include/NodeArena.hpp"
 
+// Plain: one node per character.
+// Radix: chains of single-child nodes are collapsed into multi-byte edge labels.
+enum class TrieLayout_t { Plain, Radix };
+
+// Read-only representations a built trie can be frozen into.
+// Louds: succinct bit vectors, smallest footprint.
+// DoubleArray: BASE/CHECK arrays, one array access per byte of descent.
+// Dawg: minimal word graph, shared suffixes are stored once.
+// WordRanges: every node knows its range in a sorted word pool, prefix
+//             matches are handed out as a view without traversal.
+enum class FrozenLayout_t { Louds, DoubleArray, Dawg, WordRanges };
+
+// selects the Trie_c constructor that starts no thread pool
+struct Synchronous_t {};
+inline constexpr Synchronous_t kSynchronous{};
+
+struct ScoredWord_t
+{
+  std::string _word;
+  uint32_t _weight;
+};
+
+// input of Trie_c::insertWords, the characters are not owned
+struct WordEntry_t
+{
+  std::string_view _word;
+  uint32_t _weight;
+};
+
+// one page of prefix matches, see Trie_c::findPrefixMatches( prefix, limit, ... )
+struct PrefixPage_t
+{
+  std::vector< std::string > _words;
+  // true if more matches follow; pass the last word as continuation token
+  // to get them
+  bool _more = false;
+};
+
+/*!
+  Builds the dictionary and answers stateless queries. Prefix enumeration
+  keeps per-query state and runs in a QuerySession_c; the findPrefixMatches,
+  requestResult and setCallback members below use a built-in default session.
+  Open more sessions on the same trie to serve several clients concurrently.
+  */
 class Trie_c
 {
-  using callback = std::function< void( const std::vector< std::string >& ) >;
+  friend class QuerySession_c;
+  friend class Dictionary_c;
+  using callback = QuerySession_c::callback;
 
 public:
-  Trie_c( size_t num = 0 );
+  // 'num' worker threads, at least one
+  Trie_c( size_t num = 1, TrieLayout_t layout = TrieLayout_t::Plain );
+  // no pool: queries run on the calling thread, their callbacks are called
+  // and their handles complete before findPrefixMatches returns
+  explicit Trie_c( Synchronous_t, TrieLayout_t layout = TrieLayout_t::Plain );
   Trie_c( const Trie_c& ) = delete;
-  ~Trie_c();
 
-  void insertWord( const std::string& );
-  void findPrefixMatches( const std::string& );
+  // Re-inserting a known word keeps the larger of the two weights.
+  void insertWord( std::string_view, uint32_t weight = 1 );
 
-  std::vector<std::string> requestResult() const;
+  /*!
+    Inserts many words at once. The words are partitioned by their first
+    byte and the subtries are built concurrently on the worker threads, then
+    stitched under the root. Into a trie that already holds words, or with a
+    single worker, they are inserted one by one instead.
+    */
+  void insertWords( const std::vector< WordEntry_t >& words );
 
-  void setCallback( const callback& cb );
+  /*!
+    Inserts words given in lexicographic order. Keeps the path of the previous
+    word and only branches off at the longest common prefix with it, so the
+    build is linear in the number of characters and writes nodes in order.
+    Once a word is smaller than its predecessor the rest is inserted one by
+    one, as into a trie that already holds words.
+    */
+  void buildFromSorted( const std::vector< WordEntry_t >& words );
+  QueryHandle_c findPrefixMatches( const std::string& );
+  bool containsPrefix( const std::string& ) const;
 
-private:
-  void traverse( const TrieNode_t*, const std::string&, size_t );
-  void startThread( const TrieNode_t*, const std::string&, size_t );
+  /*!
+    One page of the matches in lexicographic order: at most 'limit' words,
+    starting behind the first 'offset' of them, or behind the continuation
+    token (the last word of the previous page). Traversal stops as soon as
+    the page is full, and the subtree word counts let it jump over whole
+    subtrees in front of the page. Frozen layouts page the same way, see
+    FrozenTrie_c::findPage.
+    */
+  PrefixPage_t findPrefixMatches( const std::string& prefix, size_t limit,
+      size_t offset ) const;
+  PrefixPage_t findPrefixMatches( const std::string& prefix, size_t limit,
+      const std::string& continuation ) const;
 
-  void pushBackResult( const std::string& );
-  void clearResults();
+  /*!
+    Typo tolerant completion: all words, in lexicographic order, that start
+    with a string within 'maxEdits' insertions, deletions or substitutions of
+    the prefix. Steps a Levenshtein DP row per byte along the trie and prunes
+    a subtree as soon as no entry of the row is within the bound. Walks the
+    node arena (see hasArena()).
+    */
+  std::vector< std::string > findFuzzyPrefixMatches( const std::string& prefix,
+      uint32_t maxEdits ) const;
 
-  bool reserveFreeWorker( size_t& index );
+  /*!
+    All words matching a glob pattern such as "c?a*ge", in lexicographic
+    order; see GlobPattern_c for the syntax. The pattern is compiled to an
+    NFA that is advanced along the trie, so only subtrees it can still match
+    are entered, and the walk is spread over the worker pool, through the
+    node arena (see hasArena()). Throws std::invalid_argument for a
+    malformed pattern.
+    */
+  std::vector< std::string > findPatternMatches( const std::string& pattern ) const;
 
-  void stopAllWorkers();
+  // Synchronous findPrefixMatches: appends the matches to 'out' in
+  // lexicographic order, on the calling thread and without any session.
+  void collectPrefixMatches( const std::string& prefix,
+      std::vector< std::string >& out ) const;
 
-  std::unique_ptr< TrieNode_t > _root;
+  // number of words starting with the prefix, read from the subtree word
+  // count of the node the prefix leads to
+  size_t countPrefixMatches( const std::string& ) const;
 
-  bool _stopAllWorkers = false;
-  // size_t _numRunningWorkers = 0;
-  mutable std::mutex _accessWorkers;
-  std::vector< std::thread > _workers;
-  std::vector< std::thread > _dump;
-  //std::deque< bool > _idleWorkers;
-  std::deque< size_t > _idleWorkers;
-  mutable std::mutex _accessResults;
-  std::vector< std::string > _results;
+  /*!
+    The k heaviest words starting with the prefix, heaviest first. Searches
+    best-first on the cached subtree maximum weights, so only branches that
+    can still make it into the result are expanded. The weights live in the
+    node arena only (see hasArena()).
+    */
+  std::vector< ScoredWord_t > topK( const std::string& prefix, size_t k ) const;
+
+  /*!
+    Lazy, in-order enumeration of the words starting with the prefix, spelled
+    in a single buffer, see PrefixCursor_c. Walks only as much of the trie as
+    is consumed. The cursor points into the node arena (see hasArena()).
+    */
+  PrefixCursor_c cursor( const std::string& prefix ) const;
+
+  /*!
+    All words starting with the prefix as a view into the sorted word pool,
+    available when frozen as FrozenLayout_t::WordRanges. Costs one descent,
+    size() is the match count. Throws std::logic_error for other layouts.
+    */
+  WordRangeView_c prefixRange( const std::string& ) const;
+
+  /*!
+    Converts the built trie into an immutable representation (LOUDS by
+    default). Afterwards all prefix queries run against the frozen trie and
+    insertWord throws std::logic_error.
+    By default the node arena is released, so the trie is served from the
+    frozen layout alone. Pass keepArena = true to keep the arena next to it
+    for the queries that need it (topK, cursor, fuzzy and pattern matching);
+    the memory of both then adds up in memoryUsage().
+    */
+  void freeze( FrozenLayout_t layout = FrozenLayout_t::Louds, bool keepArena = false );
+  bool isFrozen() const { return _frozen != nullptr; }
+  /*!
+    False once freeze() released the node arena or open() replaced it.
+    topK(), cursor(), findFuzzyPrefixMatches() and findPatternMatches() run
+    on the arena alone and throw std::logic_error without it.
+    */
+  bool hasArena() const { return _hasArena; }
+
+  /*!
+    Writes a memory-mappable image of the trie (double-array units behind a
+    versioned, checksummed header). Works on a trie that still has its node
+    arena or is frozen as FrozenLayout_t::DoubleArray, throws
+    std::logic_error otherwise.
+    */
+  void save( const std::string& path ) const;
+
+  /*!
+    Replaces the contents of this trie by the image at 'path', which is
+    mapped and served as is: only the header is read up front, pages are
+    faulted in as queries touch them. The trie is frozen afterwards.
+    'verifyChecksum' additionally hashes the whole payload before serving,
+    which reads every page of the file.
+    Throws std::runtime_error for missing, incompatible or truncated images,
+    images with a corrupt root unit, and checksum mismatches if verified. A
+    corrupt payload that is not verified yields wrong matches, but is never
+    read out of bounds nor walked in circles.
+    */
+  void open( const std::string& path, bool verifyChecksum = false );
+
+  TrieLayout_t layout() const { return _layout; }
+  size_t nodeCount() const { return _arena.size(); }
+  size_t memoryUsage() const;
+
+  std::vector<std::string> requestResult() const;
+
+  void setCallback( const callback& cb );
+
+private:
+  static void insertInto( NodeArena_c&, TrieLayout_t, std::string_view,
+      uint32_t weight, std::vector< NodeIndex_t >& path );
+  static NodeIndex_t insertPathPlain( NodeArena_c&, std::string_view,
+      std::vector< NodeIndex_t >& path );
+  static NodeIndex_t insertPathRadix( NodeArena_c&, std::string_view,
+      std::vector< NodeIndex_t >& path );
+  NodeIndex_t descend( const std::string& prefix, std::string& path ) const;
+
+  PrefixPage_t findPage( const std::string& prefix, size_t limit, size_t offset,
+      const std::string* after ) const;
+  void collectPage( NodeIndex_t, std::string& path, size_t& skip, size_t limit,
+      std::vector< std::string >& out ) const;
+  size_t countUpTo( NodeIndex_t, std::string& path, std::string_view last ) const;
+
+  NodeArena_c _arena;
+  TrieLayout_t _layout;
+  std::unique_ptr< const FrozenTrie_c > _frozen;
+  // the arena may stay after freezing, see freeze()
+  bool _hasArena = true;
+  // nodes below the root visited by the current insertWord
+  std::vector< NodeIndex_t > _insertPath;
+  // bumped by every modification, sessions drop their cached state on change
+  uint64_t _version = 0;
 
-  TrieNode_t* _reachedNode;
   size_t _numWorkers;
-  std::string _input = "";
-  callback onFinnishedSearch = []( const std::vector< std::string >& ) {};
+  // shared by the traversal tasks of all sessions, submitting does not
+  // change the trie; null without workers
+  mutable std::unique_ptr< ThreadPool_c > _pool;
+
+  // last member: its queries are cancelled before the pool and the nodes go
+  QuerySession_c _defaultSession;
 };
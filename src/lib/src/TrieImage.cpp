@@ -0,0 +1,141 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "TrieImage.hpp"
+
+namespace
+{
+  constexpr char kMagic[ 8 ] = { 'A', 'C', 'T', 'R', 'I', 'E', '\0', '\0' };
+
+  uint64_t fnv1a( const char* data, size_t size )
+  {
+    uint64_t hash = 14695981039346656037ull;
+    for ( size_t i = 0; i < size; ++i )
+    {
+      hash ^= static_cast< unsigned char >( data[ i ] );
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  constexpr uint64_t payloadOffset()
+  {
+    // keep the units aligned like in memory
+    return ( sizeof( TrieImageHeader_t ) + 15 ) & ~uint64_t( 15 );
+  }
+}
+
+void TrieImage_c::save( const DoubleArrayTrie_c& trie, const std::string& path )
+{
+  using DaUnit_t = DoubleArrayTrie_c::DaUnit_t;
+
+  const char* payload = reinterpret_cast< const char* >( trie.units() );
+  const size_t payloadSize = trie.unitCount() * sizeof( DaUnit_t );
+
+  TrieImageHeader_t header;
+  std::memset( &header, 0, sizeof( header ) );
+  std::memcpy( header._magic, kMagic, sizeof( kMagic ) );
+  header._version = kVersion;
+  header._unitSize = sizeof( DaUnit_t );
+  header._unitCount = trie.unitCount();
+  header._payloadOffset = payloadOffset();
+  header._checksum = fnv1a( payload, payloadSize );
+
+  const std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream file( tmpPath, std::ios::binary | std::ios::trunc );
+    if ( !file )
+      throw std::runtime_error( "TrieImage_c: unable to write " + tmpPath );
+
+    const char padding[ 16 ] = {};
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    file.write( padding, header._payloadOffset - sizeof( header ) );
+    file.write( payload, payloadSize );
+    if ( !file.flush() )
+      throw std::runtime_error( "TrieImage_c: unable to write " + tmpPath );
+  }
+
+  if ( std::rename( tmpPath.c_str(), path.c_str() ) != 0 )
+    throw std::runtime_error( "TrieImage_c: unable to replace " + path );
+}
+
+std::unique_ptr< TrieImage_c > TrieImage_c::open( const std::string& path,
+    bool verifyChecksum )
+{
+  using DaUnit_t = DoubleArrayTrie_c::DaUnit_t;
+
+  auto file = std::make_unique< MappedFile_c >( path );
+  if ( file->size() < sizeof( TrieImageHeader_t ) )
+    throw std::runtime_error( "TrieImage_c: " + path + " is too small" );
+
+  TrieImageHeader_t header;
+  std::memcpy( &header, file->data(), sizeof( header ) );
+  if ( std::memcmp( header._magic, kMagic, sizeof( kMagic ) ) != 0 )
+    throw std::runtime_error( "TrieImage_c: " + path + " is not a trie image" );
+  if ( header._version != kVersion || header._unitSize != sizeof( DaUnit_t ) )
+    throw std::runtime_error( "TrieImage_c: " + path + " has an incompatible version" );
+
+  // units refer to each other by int32_t, and all of them must be mapped
+  if ( header._payloadOffset != payloadOffset() || file->size() < header._payloadOffset
+       || header._unitCount == 0
+       || header._unitCount > static_cast< uint64_t >( std::numeric_limits< int32_t >::max() )
+       || header._unitCount > ( file->size() - header._payloadOffset ) / sizeof( DaUnit_t ) )
+    throw std::runtime_error( "TrieImage_c: " + path + " is truncated" );
+  const uint64_t payloadSize = header._unitCount * sizeof( DaUnit_t );
+
+  const char* payload = file->data() + header._payloadOffset;
+  if ( verifyChecksum && fnv1a( payload, payloadSize ) != header._checksum )
+    throw std::runtime_error( "TrieImage_c: " + path + " fails the checksum" );
+
+  const auto* units = reinterpret_cast< const DaUnit_t* >( payload );
+  // the root has no parent, and its children lie behind it: walks that
+  // follow CHECK back to the parent can never return to the root
+  DaUnit_t root;
+  std::memcpy( &root, units, sizeof( root ) );
+  if ( root._check != -2 || ( root._firstChild != DoubleArrayTrie_c::kNoLabel && root._base < 1 ) )
+    throw std::runtime_error( "TrieImage_c: " + path + " has a corrupt root" );
+  return std::unique_ptr< TrieImage_c >(
+      new TrieImage_c( std::move( file ), units, header._unitCount ) );
+}
+
+TrieImage_c::TrieImage_c( std::unique_ptr< MappedFile_c > file,
+    const DoubleArrayTrie_c::DaUnit_t* units, size_t unitCount ) :
+  _file( std::move( file ) ), _trie( units, unitCount )
+{
+}
+
+bool TrieImage_c::containsPrefix( const std::string& prefix ) const
+{
+  return _trie.containsPrefix( prefix );
+}
+
+void TrieImage_c::findPrefixMatches( const std::string& prefix,
+    std::vector< std::string >& out ) const
+{
+  _trie.findPrefixMatches( prefix, out );
+}
+
+size_t TrieImage_c::countPrefixMatches( const std::string& prefix ) const
+{
+  return _trie.countPrefixMatches( prefix );
+}
+
+bool TrieImage_c::findPage( const std::string& prefix, size_t skip, size_t limit,
+    std::vector< std::string >& out ) const
+{
+  return _trie.findPage( prefix, skip, limit, out );
+}
+
+size_t TrieImage_c::countUpTo( const std::string& prefix, const std::string& last ) const
+{
+  return _trie.countUpTo( prefix, last );
+}
+
+size_t TrieImage_c::memoryUsage() const
+{
+  return sizeof( *this );
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DoubleArrayTrie.hpp"
+#include "FrozenTrie.hpp"
+#include "MappedFile.hpp"
+
+/*!
+  Binary trie image that is served straight from a memory mapping.
+
+  Layout: a TrieImageHeader_t followed, at _payloadOffset, by the raw
+  DoubleArrayTrie_c units. Units only refer to each other by index, so the
+  image is position independent and needs no parsing or relocation.
+  The header carries a format version, the unit size as a layout check and
+  an FNV-1a checksum of the payload.
+  */
+struct TrieImageHeader_t
+{
+  char _magic[ 8 ];
+  uint32_t _version;
+  uint32_t _unitSize;
+  uint64_t _unitCount;
+  uint64_t _payloadOffset;
+  uint64_t _checksum;
+};
+
+class TrieImage_c : public FrozenTrie_c
+{
+public:
+  // 2: units carry their subtree word count
+  static constexpr uint32_t kVersion = 2;
+
+  // writes to 'path' + ".tmp" first and renames, so readers never see a
+  // partially written image. Throws std::runtime_error on I/O errors.
+  static void save( const DoubleArrayTrie_c& trie, const std::string& path );
+
+  // Maps the image and validates its header against the file size, and its
+  // root unit. Throws std::runtime_error if the file is not a complete trie
+  // image of this version, or fails the checksum when 'verifyChecksum' is
+  // set. Verifying reads the whole payload, so it is off by default.
+  static std::unique_ptr< TrieImage_c > open( const std::string& path,
+      bool verifyChecksum = false );
+
+  bool containsPrefix( const std::string& prefix ) const override;
+  void findPrefixMatches( const std::string& prefix,
+      std::vector< std::string >& out ) const override;
+  size_t countPrefixMatches( const std::string& prefix ) const override;
+  bool findPage( const std::string& prefix, size_t skip, size_t limit,
+      std::vector< std::string >& out ) const override;
+  size_t countUpTo( const std::string& prefix, const std::string& last ) const override;
+
+  // resident heap memory only, the mapping is shared page cache
+  size_t memoryUsage() const override;
+
+private:
+  TrieImage_c( std::unique_ptr< MappedFile_c > file,
+      const DoubleArrayTrie_c::DaUnit_t* units, size_t unitCount );
+
+  std::unique_ptr< MappedFile_c > _file;
+  DoubleArrayTrie_c _trie;
+};
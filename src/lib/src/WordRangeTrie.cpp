@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "WordRangeTrie.hpp"
+
+WordRangeTrie_c::WordRangeTrie_c( const NodeArena_c& arena )
+{
+  _wordOffsets.push_back( 0 );
+  std::string path;
+  build( arena, arena.root(), 0, path );
+
+  _nodes.shrink_to_fit();
+  _edgeLabels.shrink_to_fit();
+  _edgeTargets.shrink_to_fit();
+  _pool.shrink_to_fit();
+  _wordOffsets.shrink_to_fit();
+}
+
+/*!
+  Numbers the byte positions of the arena in depth-first order. 'consumed'
+  bytes of the label of 'node' are spelled, radix edges are expanded into one
+  range node per byte. Returns the id of the new range node.
+  */
+uint32_t WordRangeTrie_c::build( const NodeArena_c& arena, NodeIndex_t node,
+    uint32_t consumed, std::string& path )
+{
+  const auto id = static_cast< uint32_t >( _nodes.size() );
+  const auto firstWord = static_cast< uint32_t >( _wordOffsets.size() - 1 );
+  _nodes.push_back( { static_cast< uint32_t >( _edgeTargets.size() ), firstWord,
+      firstWord, 0 } );
+
+  const std::string_view label = arena.label( node );
+  if ( consumed < label.size() )
+  {
+    // inside a radix edge: exactly one child
+    _nodes[ id ]._edgeCount = 1;
+    _edgeLabels.push_back( label[ consumed ] );
+    _edgeTargets.push_back( kNoNode );
+
+    path.push_back( label[ consumed ] );
+    const uint32_t child = build( arena, node, consumed + 1, path );
+    path.pop_back();
+    _edgeTargets[ _nodes[ id ]._edgeBegin ] = child;
+  }
+  else
+  {
+    if ( arena[ node ]._isLeaf )
+    {
+      _pool.append( path );
+      _wordOffsets.push_back( static_cast< uint32_t >( _pool.size() ) );
+    }
+
+    // reserve the edge block first, children append their own behind it
+    const uint32_t edgeBegin = _nodes[ id ]._edgeBegin;
+    _nodes[ id ]._edgeCount = static_cast< uint16_t >( arena.childCount( node ) );
+    arena.forEachChild( node, [ & ]( NodeIndex_t child )
+    {
+      _edgeLabels.push_back( arena[ child ]._letter );
+      _edgeTargets.push_back( kNoNode );
+    } );
+
+    uint32_t edge = edgeBegin;
+    arena.forEachChild( node, [ & ]( NodeIndex_t child )
+    {
+      path.push_back( arena[ child ]._letter );
+      const uint32_t target = build( arena, child, 1, path );
+      path.pop_back();
+      _edgeTargets[ edge++ ] = target;
+    } );
+  }
+
+  _nodes[ id ]._wordEnd = static_cast< uint32_t >( _wordOffsets.size() - 1 );
+  return id;
+}
+
+uint32_t WordRangeTrie_c::descend( const std::string& prefix ) const
+{
+  uint32_t node = 0;
+  for ( const char letter : prefix )
+  {
+    const RangeNode_t& n = _nodes[ node ];
+    const auto key = static_cast< unsigned char >( letter );
+    uint32_t next = kNoNode;
+    for ( uint32_t edge = n._edgeBegin; edge < n._edgeBegin + n._edgeCount; ++edge )
+    {
+      const auto edgeKey = static_cast< unsigned char >( _edgeLabels[ edge ] );
+      if ( edgeKey == key )
+      {
+        next = _edgeTargets[ edge ];
+        break;
+      }
+      if ( edgeKey > key )
+        break;
+    }
+    if ( next == kNoNode )
+      return kNoNode;
+    node = next;
+  }
+  return node;
+}
+
+WordRangeView_c WordRangeTrie_c::prefixRange( const std::string& prefix ) const
+{
+  const uint32_t node = descend( prefix );
+  if ( node == kNoNode )
+    return WordRangeView_c( this, 0, 0 );
+  return WordRangeView_c( this, _nodes[ node ]._wordBegin, _nodes[ node ]._wordEnd );
+}
+
+bool WordRangeTrie_c::containsPrefix( const std::string& prefix ) const
+{
+  return !prefixRange( prefix ).empty();
+}
+
+void WordRangeTrie_c::findPrefixMatches( const std::string& prefix,
+    std::vector< std::string >& out ) const
+{
+  const WordRangeView_c range = prefixRange( prefix );
+  out.reserve( out.size() + range.size() );
+  for ( const std::string_view word : range )
+    out.emplace_back( word );
+}
+
+size_t WordRangeTrie_c::countPrefixMatches( const std::string& prefix ) const
+{
+  return prefixRange( prefix ).size();
+}
+
+bool WordRangeTrie_c::findPage( const std::string& prefix, size_t skip, size_t limit,
+    std::vector< std::string >& out ) const
+{
+  // the page is a slice of the range
+  const WordRangeView_c range = prefixRange( prefix );
+  const size_t begin = std::min( skip, range.size() );
+  const size_t end = begin + std::min( limit, range.size() - begin );
+  for ( size_t i = begin; i < end; ++i )
+    out.emplace_back( range[ i ] );
+  return end < range.size();
+}
+
+size_t WordRangeTrie_c::countUpTo( const std::string& prefix, const std::string& last ) const
+{
+  // binary search for the first word of the range behind 'last'
+  const WordRangeView_c range = prefixRange( prefix );
+  size_t begin = 0;
+  size_t end = range.size();
+  while ( begin < end )
+  {
+    const size_t mid = ( begin + end ) / 2;
+    if ( range[ mid ] <= last )
+      begin = mid + 1;
+    else
+      end = mid;
+  }
+  return begin;
+}
+
+size_t WordRangeTrie_c::memoryUsage() const
+{
+  return sizeof( *this ) + _nodes.capacity() * sizeof( RangeNode_t )
+    + _edgeLabels.capacity() + _edgeTargets.capacity() * sizeof( uint32_t )
+    + _pool.capacity() + _wordOffsets.capacity() * sizeof( uint32_t );
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FrozenTrie.hpp"
+#include "include/NodeArena.hpp"
+
+class WordRangeTrie_c;
+
+/*!
+  Contiguous run [begin, end) of the lexicographically sorted word pool of a
+  WordRangeTrie_c. Iterating yields std::string_view into the pool, which stay
+  valid as long as the trie lives.
+  */
+class WordRangeView_c
+{
+public:
+  class iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = std::string_view;
+
+    iterator( const WordRangeTrie_c* trie, uint32_t index ) : _trie( trie ), _index( index ) {}
+
+    std::string_view operator*() const;
+    iterator& operator++() { ++_index; return *this; }
+    iterator operator++( int ) { iterator old = *this; ++_index; return old; }
+    bool operator==( const iterator& other ) const { return _index == other._index; }
+    bool operator!=( const iterator& other ) const { return _index != other._index; }
+
+  private:
+    const WordRangeTrie_c* _trie;
+    uint32_t _index;
+  };
+
+  WordRangeView_c() = default;
+  WordRangeView_c( const WordRangeTrie_c* trie, uint32_t begin, uint32_t end ) :
+    _trie( trie ), _begin( begin ), _end( end ) {}
+
+  iterator begin() const { return iterator( _trie, _begin ); }
+  iterator end() const { return iterator( _trie, _end ); }
+  size_t size() const { return _end - _begin; }
+  bool empty() const { return _begin == _end; }
+  std::string_view operator[]( size_t i ) const { return *iterator( _trie, _begin + static_cast< uint32_t >( i ) ); }
+
+private:
+  const WordRangeTrie_c* _trie = nullptr;
+  uint32_t _begin = 0;
+  uint32_t _end = 0;
+};
+
+/*!
+  Frozen trie in which every node knows the range [begin, end) of the sorted
+  word pool holding the words below it. Depth-first order is lexicographic
+  order, so these ranges are contiguous. A prefix query is a descent of
+  |prefix| steps followed by handing out the range: no traversal, no string
+  building, and the number of matches is known up front.
+  */
+class WordRangeTrie_c : public FrozenTrie_c
+{
+public:
+  explicit WordRangeTrie_c( const NodeArena_c& arena );
+
+  WordRangeView_c prefixRange( const std::string& prefix ) const;
+
+  bool containsPrefix( const std::string& prefix ) const override;
+  void findPrefixMatches( const std::string& prefix,
+      std::vector< std::string >& out ) const override;
+  size_t countPrefixMatches( const std::string& prefix ) const override;
+  bool findPage( const std::string& prefix, size_t skip, size_t limit,
+      std::vector< std::string >& out ) const override;
+  size_t countUpTo( const std::string& prefix, const std::string& last ) const override;
+
+  size_t memoryUsage() const override;
+
+  size_t wordCount() const { return _wordOffsets.size() - 1; }
+  std::string_view word( uint32_t index ) const
+  {
+    return std::string_view( _pool.data() + _wordOffsets[ index ],
+        _wordOffsets[ index + 1 ] - _wordOffsets[ index ] );
+  }
+
+private:
+  static constexpr uint32_t kNoNode = UINT32_MAX;
+
+  struct RangeNode_t
+  {
+    uint32_t _edgeBegin;
+    uint32_t _wordBegin;
+    uint32_t _wordEnd;
+    uint16_t _edgeCount;
+  };
+
+  uint32_t build( const NodeArena_c& arena, NodeIndex_t node, uint32_t consumed,
+      std::string& path );
+  uint32_t descend( const std::string& prefix ) const;
+
+  std::vector< RangeNode_t > _nodes;
+  // edges of a node are [ _edgeBegin, _edgeBegin + _edgeCount ), sorted by byte
+  std::string _edgeLabels;
+  std::vector< uint32_t > _edgeTargets;
+  // word i is _pool[ _wordOffsets[ i ], _wordOffsets[ i + 1 ] )
+  std::string _pool;
+  std::vector< uint32_t > _wordOffsets;
+};
+
+inline std::string_view WordRangeView_c::iterator::operator*() const
+{
+  return _trie->word( _index );
+}
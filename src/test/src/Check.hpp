@@ -0,0 +1,57 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*!
+  Minimal test support: CHECK reports a failed condition and goes on, the
+  test program exits with the number of failures.
+  */
+namespace test_n
+{
+  inline size_t& failures()
+  {
+    static size_t count = 0;
+    return count;
+  }
+
+  inline size_t& checks()
+  {
+    static size_t count = 0;
+    return count;
+  }
+
+  inline void check( bool condition, const char* expression, const std::string& context,
+      const char* file, int line )
+  {
+    ++checks();
+    if ( condition )
+      return;
+    ++failures();
+    std::cerr << file << ":" << line << ": CHECK( " << expression << " ) failed";
+    if ( !context.empty() )
+      std::cerr << " for " << context;
+    std::cerr << "\n";
+  }
+
+  inline std::string quote( const std::string& text )
+  {
+    std::ostringstream out;
+    out << '"' << text << '"';
+    return out.str();
+  }
+
+  inline int result( const char* name )
+  {
+    std::cout << name << ": " << ( failures() == 0 ? "passed" : "FAILED" ) << ", "
+      << checks() << " checks, " << failures() << " failures\n";
+    return failures() == 0 ? 0 : 1;
+  }
+}
+
+#define CHECK( condition ) test_n::check( ( condition ), #condition, "", __FILE__, __LINE__ )
+// CHECK that names what was tested, e.g. the prefix
+#define CHECK_FOR( condition, context ) \
+  test_n::check( ( condition ), #condition, ( context ), __FILE__, __LINE__ )
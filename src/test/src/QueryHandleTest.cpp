@@ -0,0 +1,312 @@
+/*!
+  Builds QueryHandle_c as a C++20 awaitable and checks that a coroutine
+  resumed by a query can go on with the same session: await the next query,
+  or destroy the session. Also checks a callback that starts the next query,
+  and that cancelled queries complete their handles as cancelled without
+  calling back, and that threads with a session each can query one trie at
+  the same time. Compiled as C++20, unlike the library.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.hpp"
+#include "lib/src/Trie.hpp"
+
+namespace
+{
+  // a coroutine that starts right away and nobody waits for
+  struct Detached_t
+  {
+    struct promise_type
+    {
+      Detached_t get_return_object() { return {}; }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { std::terminate(); }
+    };
+  };
+
+  std::vector< std::string > expectedMatches( const std::vector< std::string >& sorted,
+      const std::string& prefix )
+  {
+    std::vector< std::string > matches;
+    for ( const auto& word : sorted )
+      if ( word.compare( 0, prefix.size(), prefix ) == 0 )
+        matches.push_back( word );
+    return matches;
+  }
+
+  // typing and deleting: every query follows the last one on the same session
+  const std::vector< std::string > kPrefixes = { "", "a", "ab", "abc", "ab", "b", "", "ca", "c" };
+
+  Detached_t typeAhead( QuerySession_c& session, std::vector< std::vector< std::string > >& results,
+      std::promise< void >& finished )
+  {
+    for ( const auto& prefix : kPrefixes )
+      results.push_back( co_await session.findPrefixMatches( prefix ) );
+    finished.set_value();
+  }
+
+  Detached_t queryAndDestroy( std::unique_ptr< QuerySession_c >& session,
+      std::vector< std::string >& result, std::promise< void >& finished )
+  {
+    result = co_await session->findPrefixMatches( "a" );
+    session.reset();
+    finished.set_value();
+  }
+
+  void testAwaitable( Trie_c& trie, const std::string& context,
+      const std::vector< std::string >& words )
+  {
+    for ( const auto& word : words )
+      trie.insertWord( word );
+    std::vector< std::string > sorted = words;
+    std::sort( sorted.begin(), sorted.end() );
+    sorted.erase( std::unique( sorted.begin(), sorted.end() ), sorted.end() );
+
+    {
+      QuerySession_c session( trie );
+      std::vector< std::vector< std::string > > results;
+      std::promise< void > finished;
+      typeAhead( session, results, finished );
+      finished.get_future().wait();
+      CHECK_FOR( results.size() == kPrefixes.size(), context );
+      for ( size_t i = 0; i < results.size() && i < kPrefixes.size(); ++i )
+        CHECK_FOR( results[ i ] == expectedMatches( sorted, kPrefixes[ i ] ),
+            context + ", prefix " + test_n::quote( kPrefixes[ i ] ) );
+    }
+
+    {
+      auto session = std::make_unique< QuerySession_c >( trie );
+      std::vector< std::string > result;
+      std::promise< void > finished;
+      queryAndDestroy( session, result, finished );
+      finished.get_future().wait();
+      CHECK_FOR( !session, context );
+      CHECK_FOR( result == expectedMatches( sorted, "a" ), context );
+    }
+
+    {
+      // the first callback starts the second query, the second one reports
+      QuerySession_c session( trie );
+      std::promise< std::vector< std::string > > second;
+      size_t calls = 0;
+      session.setCallback( [ & ]( const std::vector< std::string >& matches )
+      {
+        if ( ++calls == 1 )
+          session.findPrefixMatches( "b" );
+        else
+          second.set_value( matches );
+      } );
+      session.findPrefixMatches( "ca" );
+      CHECK_FOR( second.get_future().get() == expectedMatches( sorted, "b" ), context );
+    }
+  }
+
+  bool completedAsCancelled( const QueryHandle_c& handle )
+  {
+    try
+    {
+      handle.get();
+    }
+    catch ( const QueryCancelled_c& )
+    {
+      return true;
+    }
+    return false;
+  }
+
+  // Keeps the only worker of a trie in a query callback until released, so
+  // that the tasks of other queries stay queued behind it
+  class BlockedWorker_c
+  {
+  public:
+    explicit BlockedWorker_c( const Trie_c& trie ) : _session( trie )
+    {
+      auto entered = std::make_shared< std::promise< void > >();
+      std::future< void > inCallback = entered->get_future();
+      _session.setCallback( [ entered, gate = _gate.get_future().share() ]
+          ( const std::vector< std::string >& )
+      {
+        entered->set_value();
+        gate.wait();
+      } );
+      _session.findPrefixMatches( "" );
+      inCallback.wait();
+    }
+    ~BlockedWorker_c() { release(); }
+
+    void release()
+    {
+      if ( !_released )
+        _gate.set_value();
+      _released = true;
+    }
+
+  private:
+    std::promise< void > _gate;
+    bool _released = false;
+    QuerySession_c _session;
+  };
+
+  void testCancellation( const std::vector< std::string >& words )
+  {
+    Trie_c trie( 1, TrieLayout_t::Radix );
+    for ( const auto& word : words )
+      trie.insertWord( word );
+    std::vector< std::string > sorted = words;
+    std::sort( sorted.begin(), sorted.end() );
+    sorted.erase( std::unique( sorted.begin(), sorted.end() ), sorted.end() );
+
+    // the callback is called after the handle completed, so the calls are
+    // waited for on their own
+    QuerySession_c session( trie );
+    std::mutex access;
+    std::condition_variable called;
+    std::vector< std::vector< std::string > > calls;
+    session.setCallback( [ & ]( const std::vector< std::string >& matches )
+    {
+      std::lock_guard< std::mutex > guard( access );
+      calls.push_back( matches );
+      called.notify_all();
+    } );
+    const auto callsOnceThere = [ & ]( size_t count )
+    {
+      std::unique_lock< std::mutex > lock( access );
+      called.wait( lock, [ & ] { return calls.size() >= count; } );
+      return calls;
+    };
+
+    {
+      // a new query supersedes one whose tasks did not run yet
+      BlockedWorker_c blocked( trie );
+      const QueryHandle_c first = session.findPrefixMatches( "" );
+      CHECK( !first.ready() );
+      // the next query waits for the first one to be gone, which takes the
+      // worker; give it time to cancel the first one before releasing it
+      std::future< QueryHandle_c > second = std::async( std::launch::async,
+          [ & ] { return session.findPrefixMatches( "a" ); } );
+      std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+      blocked.release();
+      CHECK( completedAsCancelled( first ) );
+      CHECK( second.get().get() == expectedMatches( sorted, "a" ) );
+    }
+
+    {
+      // the handle cancels without waiting, the tasks give up once they run
+      BlockedWorker_c blocked( trie );
+      const QueryHandle_c handle = session.findPrefixMatches( "" );
+      handle.cancel();
+      blocked.release();
+      CHECK( completedAsCancelled( handle ) );
+      CHECK( session.findPrefixMatches( "b" ).get() == expectedMatches( sorted, "b" ) );
+    }
+
+    {
+      // the session cancels and waits for the queued tasks
+      BlockedWorker_c blocked( trie );
+      const QueryHandle_c handle = session.findPrefixMatches( "c" );
+      std::atomic< bool > returned{ false };
+      std::thread canceller( [ & ]
+      {
+        session.cancel();
+        returned = true;
+      } );
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+      CHECK( !returned );
+      blocked.release();
+      canceller.join();
+      CHECK( completedAsCancelled( handle ) );
+    }
+
+    // only the queries that were not cancelled called back
+    session.findPrefixMatches( "ab" );
+    const std::vector< std::vector< std::string > > seen = callsOnceThere( 3 );
+    CHECK( seen.size() == 3 );
+    if ( seen.size() == 3 )
+    {
+      CHECK( seen[ 0 ] == expectedMatches( sorted, "a" ) );
+      CHECK( seen[ 1 ] == expectedMatches( sorted, "b" ) );
+      CHECK( seen[ 2 ] == expectedMatches( sorted, "ab" ) );
+    }
+  }
+
+  // every thread types its own prefixes into its own session, all on one trie
+  void testConcurrentSessions( const std::vector< std::string >& words )
+  {
+    Trie_c trie( 4, TrieLayout_t::Radix );
+    for ( const auto& word : words )
+      trie.insertWord( word );
+    std::vector< std::string > sorted = words;
+    std::sort( sorted.begin(), sorted.end() );
+    sorted.erase( std::unique( sorted.begin(), sorted.end() ), sorted.end() );
+
+    constexpr size_t kThreads = 4;
+    constexpr size_t kQueries = 200;
+    std::vector< std::vector< std::string > > prefixes( kThreads );
+    std::mt19937 rng( 11 );
+    for ( auto& typed : prefixes )
+      for ( size_t i = 0; i < kQueries; ++i )
+      {
+        const std::string& word = words[ rng() % words.size() ];
+        typed.push_back( word.substr( 0, rng() % ( word.size() + 1 ) ) );
+      }
+
+    std::vector< std::vector< std::vector< std::string > > > results( kThreads );
+    std::vector< std::thread > threads;
+    for ( size_t t = 0; t < kThreads; ++t )
+      threads.emplace_back( [ &, t ]
+      {
+        QuerySession_c session( trie );
+        for ( const auto& prefix : prefixes[ t ] )
+          results[ t ].push_back( session.findPrefixMatches( prefix ).get() );
+      } );
+    for ( auto& thread : threads )
+      thread.join();
+
+    for ( size_t t = 0; t < kThreads; ++t )
+      for ( size_t i = 0; i < kQueries && i < results[ t ].size(); ++i )
+        CHECK_FOR( results[ t ][ i ] == expectedMatches( sorted, prefixes[ t ][ i ] ),
+            "thread " + std::to_string( t ) + ", prefix " + test_n::quote( prefixes[ t ][ i ] ) );
+  }
+}
+
+int main()
+{
+  // big enough for the traversal to be split into tasks
+  std::mt19937 rng( 7 );
+  std::vector< std::string > words;
+  for ( size_t i = 0; i < 5000; ++i )
+  {
+    std::string word( 1 + rng() % 9, ' ' );
+    for ( auto& letter : word )
+      letter = static_cast< char >( 'a' + rng() % 3 );
+    words.push_back( word );
+  }
+
+  {
+    Trie_c trie( kSynchronous, TrieLayout_t::Radix );
+    testAwaitable( trie, "no workers", words );
+  }
+  // 0 workers are taken as one
+  for ( const size_t numWorkers : { 0, 1, 4 } )
+  {
+    Trie_c trie( numWorkers, TrieLayout_t::Radix );
+    testAwaitable( trie, std::to_string( numWorkers ) + " workers", words );
+  }
+  testCancellation( words );
+  testConcurrentSessions( words );
+  return test_n::result( "query_handle_test" );
+}
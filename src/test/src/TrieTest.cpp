@@ -0,0 +1,816 @@
+/*!
+  Checks every trie layout and frozen backend against a brute-force scan of
+  the same word lists: the plain and the radix layout, built word by word or
+  in bulk, the LOUDS, double array, DAWG and word range backends, and tries
+  reopened from images. Queries that need the node arena are run on frozen
+  tries that kept it.
+  Usage: trie_test [word file]
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fnmatch.h>
+#include <functional>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.hpp"
+#include "lib/src/Dictionary.hpp"
+#include "lib/src/GlobPattern.hpp"
+#include "lib/src/ShardedTrie.hpp"
+#include "lib/src/Trie.hpp"
+#include "lib/src/TrieImage.hpp"
+
+namespace
+{
+  struct WordList_t
+  {
+    std::string _name;
+    std::vector< std::string > _words;
+  };
+
+  std::vector< WordList_t > wordLists( int argc, char** argv )
+  {
+    std::vector< WordList_t > lists;
+    if ( argc > 1 )
+    {
+      WordList_t file{ argv[ 1 ], {} };
+      std::ifstream in( argv[ 1 ] );
+      std::string line;
+      while ( std::getline( in, line ) )
+        file._words.push_back( line );
+      CHECK_FOR( !file._words.empty(), file._name );
+      lists.push_back( std::move( file ) );
+    }
+
+    // few letters, so words share long prefixes and are prefixes of each
+    // other; the empty word included
+    std::mt19937 rng( 42 );
+    WordList_t dense{ "dense", { "" } };
+    for ( size_t i = 0; i < 3000; ++i )
+    {
+      std::string word( rng() % 9, ' ' );
+      for ( auto& letter : word )
+        letter = static_cast< char >( 'a' + rng() % 3 );
+      dense._words.push_back( word );
+    }
+    lists.push_back( std::move( dense ) );
+
+    // bytes above 0x7f have to sort behind ASCII
+    WordList_t bytes{ "high bytes", {} };
+    const std::string alphabet = "az\x7f\x80\xc3\xa9\xff";
+    for ( size_t i = 0; i < 2000; ++i )
+    {
+      std::string word( 1 + rng() % 6, ' ' );
+      for ( auto& letter : word )
+        letter = alphabet[ rng() % alphabet.size() ];
+      bytes._words.push_back( word );
+    }
+    lists.push_back( std::move( bytes ) );
+    return lists;
+  }
+
+  // every prefix of a sample of the words, and some that match nothing
+  std::vector< std::string > prefixesOf( const std::vector< std::string >& words )
+  {
+    std::vector< std::string > prefixes{ "", "zzzz", "\xff\xff\xff\xff\xff\xff\xff" };
+    for ( size_t i = 0; i < words.size(); i += 7 )
+      for ( size_t length = 0; length <= words[ i ].size(); ++length )
+        prefixes.push_back( words[ i ].substr( 0, length ) );
+    prefixes.push_back( words.front() + "q" );
+    std::sort( prefixes.begin(), prefixes.end() );
+    prefixes.erase( std::unique( prefixes.begin(), prefixes.end() ), prefixes.end() );
+    return prefixes;
+  }
+
+  std::vector< std::string > expectedMatches( const std::vector< std::string >& sorted,
+      const std::string& prefix )
+  {
+    std::vector< std::string > matches;
+    for ( auto it = std::lower_bound( sorted.begin(), sorted.end(), prefix );
+          it != sorted.end() && it->compare( 0, prefix.size(), prefix ) == 0; ++it )
+      matches.push_back( *it );
+    return matches;
+  }
+
+  std::unique_ptr< Trie_c > buildTrie( const std::vector< std::string >& words,
+      TrieLayout_t layout )
+  {
+    auto trie = std::make_unique< Trie_c >( 2, layout );
+    for ( const auto& word : words )
+      trie->insertWord( word );
+    return trie;
+  }
+
+  // pages by offset and by continuation token must add up to the matches
+  void checkPages( const Trie_c& trie, const std::string& prefix,
+      const std::vector< std::string >& expected, const std::string& context )
+  {
+    for ( const size_t limit : { 1, 3, 7 } )
+    {
+      std::vector< std::string > byOffset;
+      std::vector< std::string > byToken;
+      PrefixPage_t page = trie.findPrefixMatches( prefix, limit, size_t( 0 ) );
+      for ( size_t round = 0; ; ++round )
+      {
+        CHECK_FOR( page._words.size() <= limit, context );
+        byOffset.insert( byOffset.end(), page._words.begin(), page._words.end() );
+        if ( !page._more || page._words.empty() || round > expected.size() )
+          break;
+        page = trie.findPrefixMatches( prefix, limit, byOffset.size() );
+      }
+      CHECK_FOR( byOffset == expected, context );
+
+      page = trie.findPrefixMatches( prefix, limit, size_t( 0 ) );
+      for ( size_t round = 0; ; ++round )
+      {
+        byToken.insert( byToken.end(), page._words.begin(), page._words.end() );
+        if ( !page._more || page._words.empty() || round > expected.size() )
+          break;
+        page = trie.findPrefixMatches( prefix, limit, page._words.back() );
+      }
+      CHECK_FOR( byToken == expected, context );
+    }
+
+    // a token that is no word: everything behind the prefix itself
+    const size_t exact = !expected.empty() && expected.front() == prefix ? 1 : 0;
+    const PrefixPage_t rest = trie.findPrefixMatches( prefix, expected.size() + 1, prefix );
+    CHECK_FOR( rest._words == std::vector< std::string >( expected.begin() + exact, expected.end() ), context );
+    CHECK_FOR( !rest._more, context );
+    CHECK_FOR( trie.findPrefixMatches( prefix, 1, expected.size() )._words.empty(), context );
+  }
+
+  void checkTrie( const std::string& name, Trie_c& trie, const WordList_t& list )
+  {
+    std::vector< std::string > sorted = list._words;
+    std::sort( sorted.begin(), sorted.end() );
+    sorted.erase( std::unique( sorted.begin(), sorted.end() ), sorted.end() );
+
+    for ( const auto& prefix : prefixesOf( list._words ) )
+    {
+      const std::string context = name + ", " + list._name + ", prefix " + test_n::quote( prefix );
+      const std::vector< std::string > expected = expectedMatches( sorted, prefix );
+
+      CHECK_FOR( trie.findPrefixMatches( prefix ).get() == expected, context );
+      std::vector< std::string > collected;
+      trie.collectPrefixMatches( prefix, collected );
+      CHECK_FOR( collected == expected, context );
+      CHECK_FOR( trie.countPrefixMatches( prefix ) == expected.size(), context );
+      CHECK_FOR( trie.containsPrefix( prefix ) == !expected.empty(), context );
+      checkPages( trie, prefix, expected, context );
+    }
+  }
+
+  void testLayouts( const WordList_t& list )
+  {
+    const auto plain = buildTrie( list._words, TrieLayout_t::Plain );
+    const auto radix = buildTrie( list._words, TrieLayout_t::Radix );
+    checkTrie( "plain", *plain, list );
+    checkTrie( "radix", *radix, list );
+    CHECK_FOR( radix->nodeCount() <= plain->nodeCount(), list._name );
+  }
+
+  // subtree word counts must also be right after the bulk builds, frozen
+  // layouts copy them
+  void testBulkBuilds( const WordList_t& list )
+  {
+    std::vector< std::string > sorted = list._words;
+    std::sort( sorted.begin(), sorted.end() );
+    std::vector< WordEntry_t > entries;
+    for ( const auto& word : list._words )
+      entries.push_back( { word, 1 } );
+    std::vector< WordEntry_t > sortedEntries;
+    for ( const auto& word : sorted )
+      sortedEntries.push_back( { word, 1 } );
+
+    for ( const TrieLayout_t layout : { TrieLayout_t::Plain, TrieLayout_t::Radix } )
+    {
+      Trie_c parallel( 4, layout );
+      parallel.insertWords( entries );
+      checkTrie( "insertWords", parallel, list );
+      parallel.freeze( FrozenLayout_t::Louds );
+      checkTrie( "insertWords, frozen", parallel, list );
+
+      Trie_c fromSorted( 1, layout );
+      fromSorted.buildFromSorted( sortedEntries );
+      checkTrie( "buildFromSorted", fromSorted, list );
+      fromSorted.freeze( FrozenLayout_t::DoubleArray );
+      checkTrie( "buildFromSorted, frozen", fromSorted, list );
+    }
+  }
+
+  void testFrozen( const WordList_t& list )
+  {
+    const std::pair< FrozenLayout_t, const char* > layouts[] = {
+      { FrozenLayout_t::Louds, "louds" },
+      { FrozenLayout_t::DoubleArray, "double array" },
+      { FrozenLayout_t::Dawg, "dawg" },
+      { FrozenLayout_t::WordRanges, "word ranges" } };
+
+    for ( const TrieLayout_t layout : { TrieLayout_t::Plain, TrieLayout_t::Radix } )
+      for ( const auto& [ frozenLayout, name ] : layouts )
+      {
+        const auto trie = buildTrie( list._words, layout );
+        trie->freeze( frozenLayout );
+        CHECK_FOR( trie->isFrozen(), name );
+        checkTrie( std::string( "frozen " ) + name, *trie, list );
+      }
+  }
+
+  // a trie without workers answers on the caller's thread, as every shard does
+  void testWithoutWorkers( const WordList_t& list )
+  {
+    for ( const TrieLayout_t layout : { TrieLayout_t::Plain, TrieLayout_t::Radix } )
+    {
+      Trie_c trie( kSynchronous, layout );
+      for ( const auto& word : list._words )
+        trie.insertWord( word );
+      checkTrie( "no workers", trie, list );
+      CHECK_FOR( trie.findPrefixMatches( "" ).ready(), list._name );
+
+      // the callback runs before the query returns, on the calling thread
+      QuerySession_c session( trie );
+      const std::thread::id caller = std::this_thread::get_id();
+      size_t calls = 0;
+      session.setCallback( [ & ]( const std::vector< std::string >& )
+      {
+        CHECK_FOR( std::this_thread::get_id() == caller, list._name );
+        ++calls;
+      } );
+      session.findPrefixMatches( "" );
+      CHECK_FOR( calls == 1, list._name );
+    }
+
+    std::vector< std::string > sorted = list._words;
+    std::sort( sorted.begin(), sorted.end() );
+    sorted.erase( std::unique( sorted.begin(), sorted.end() ), sorted.end() );
+    ShardedTrie_c sharded( list._words, 3 );
+    for ( const auto& prefix : prefixesOf( list._words ) )
+    {
+      const std::string context = "sharded, " + list._name + ", prefix " + test_n::quote( prefix );
+      const std::vector< std::string > expected = expectedMatches( sorted, prefix );
+      CHECK_FOR( sharded.countPrefixMatches( prefix ) == expected.size(), context );
+
+      std::promise< std::vector< std::string > > found;
+      sharded.findPrefixMatches( prefix, [ & ]( const std::vector< std::string >& matches )
+      {
+        found.set_value( matches );
+      } );
+      CHECK_FOR( found.get_future().get() == expected, context );
+    }
+  }
+
+  // a throwing body neither stops the others nor leaves tasks running
+  void testForEachThrows()
+  {
+    ThreadPool_c pool( 4 );
+    std::atomic< size_t > calls{ 0 };
+    const auto body = [ & ]( size_t i )
+    {
+      ++calls;
+      if ( i % 7 == 3 )
+        throw std::runtime_error( std::to_string( i ) );
+    };
+    bool thrown = false;
+    try
+    {
+      pool.forEach( 100, body );
+    }
+    catch ( const std::runtime_error& )
+    {
+      thrown = true;
+    }
+    CHECK( thrown );
+    CHECK( calls == 100 );
+
+    // the same inline on a worker
+    std::promise< bool > thrownOnWorker;
+    pool.submit( [ & ]
+    {
+      try
+      {
+        pool.forEach( 10, body );
+        thrownOnWorker.set_value( false );
+      }
+      catch ( const std::runtime_error& )
+      {
+        thrownOnWorker.set_value( true );
+      }
+    } );
+    CHECK( thrownOnWorker.get_future().get() );
+    CHECK( calls == 110 );
+  }
+
+  uint32_t weightOf( const std::string& word )
+  {
+    return static_cast< uint32_t >( std::hash< std::string >()( word ) % 100 );
+  }
+
+  // true if some prefix of 'word' is within 'maxEdits' of 'prefix'
+  bool fuzzyMatches( const std::string& prefix, const std::string& word, uint32_t maxEdits )
+  {
+    // row[ i ]: distance of prefix[ 0, i ) to the part of 'word' read so far
+    std::vector< uint32_t > row( prefix.size() + 1 );
+    for ( size_t i = 0; i <= prefix.size(); ++i )
+      row[ i ] = static_cast< uint32_t >( i );
+    bool matched = row.back() <= maxEdits;
+    for ( const char letter : word )
+    {
+      std::vector< uint32_t > next( row.size() );
+      next[ 0 ] = row[ 0 ] + 1;
+      for ( size_t i = 1; i <= prefix.size(); ++i )
+        next[ i ] = std::min( { row[ i ] + 1, next[ i - 1 ] + 1,
+            row[ i - 1 ] + ( prefix[ i - 1 ] == letter ? 0 : 1 ) } );
+      row = std::move( next );
+      matched = matched || row.back() <= maxEdits;
+    }
+    return matched;
+  }
+
+  // the byte escaped, if glob syntax would take it for more than itself
+  std::string literal( char letter )
+  {
+    const std::string special = "*?[]\\!^-";
+    return special.find( letter ) == std::string::npos ? std::string( 1, letter ) : "\\" + std::string( 1, letter );
+  }
+
+  // patterns with literals, '?', '*' and sets, made from the words
+  std::vector< std::string > patternsOf( const std::vector< std::string >& words )
+  {
+    std::vector< std::string > patterns = { "*", "?", "a*", "*a", "[a-c]?*", "[!a]*b*", "*[\x80-\xff]*" };
+    for ( size_t i = 0; i < words.size(); i += 1 + words.size() / 15 )
+    {
+      std::string escaped;
+      for ( const char letter : words[ i ] )
+        escaped += literal( letter );
+      patterns.push_back( escaped );
+      patterns.push_back( escaped + "*" );
+      if ( words[ i ].size() > 2 )
+      {
+        patterns.push_back( literal( words[ i ][ 0 ] ) + "?" + literal( words[ i ][ 2 ] ) + "*" );
+        patterns.push_back( "*" + literal( words[ i ].back() ) );
+      }
+    }
+    return patterns;
+  }
+
+  // fnmatch() as reference, as far as it reads bytes as bytes
+  bool globMatches( const std::string& pattern, const std::string& word )
+  {
+    const auto ascii = []( const std::string& text )
+    {
+      return std::all_of( text.begin(), text.end(), []( char c ) { return static_cast< unsigned char >( c ) < 0x80; } );
+    };
+    if ( ascii( pattern ) && ascii( word ) )
+      return fnmatch( pattern.c_str(), word.c_str(), 0 ) == 0;
+    return GlobPattern_c( pattern ).matches( word );
+  }
+
+  bool throwsLogicError( const std::function< void() >& query )
+  {
+    try
+    {
+      query();
+    }
+    catch ( const std::logic_error& )
+    {
+      return true;
+    }
+    return false;
+  }
+
+  /*!
+    The queries that walk the node arena must give the same answers on a
+    trie frozen with its arena kept, and refuse to run once it is released.
+    */
+  void testArenaQueries( const WordList_t& list )
+  {
+    std::vector< std::string > sorted = list._words;
+    std::sort( sorted.begin(), sorted.end() );
+    sorted.erase( std::unique( sorted.begin(), sorted.end() ), sorted.end() );
+
+    Trie_c trie( 2, TrieLayout_t::Radix );
+    for ( const auto& word : list._words )
+      trie.insertWord( word, weightOf( word ) );
+    trie.freeze( FrozenLayout_t::Louds, true );
+    CHECK_FOR( trie.hasArena(), list._name );
+
+    for ( const auto& prefix : prefixesOf( list._words ) )
+    {
+      const std::string context = list._name + ", prefix " + test_n::quote( prefix );
+      const std::vector< std::string > expected = expectedMatches( sorted, prefix );
+
+      std::vector< uint32_t > weights;
+      for ( const auto& word : expected )
+        weights.push_back( weightOf( word ) );
+      std::sort( weights.rbegin(), weights.rend() );
+      weights.resize( std::min< size_t >( weights.size(), 5 ) );
+      const std::vector< ScoredWord_t > best = trie.topK( prefix, 5 );
+      CHECK_FOR( best.size() == weights.size(), context );
+      for ( size_t i = 0; i < best.size() && i < weights.size(); ++i )
+      {
+        CHECK_FOR( best[ i ]._weight == weights[ i ], context );
+        CHECK_FOR( best[ i ]._weight == weightOf( best[ i ]._word ), context );
+        CHECK_FOR( std::binary_search( expected.begin(), expected.end(), best[ i ]._word ), context );
+      }
+
+      std::vector< std::string > walked;
+      PrefixCursor_c cursor = trie.cursor( prefix );
+      for ( const std::string_view word : cursor )
+        walked.emplace_back( word );
+      CHECK_FOR( walked == expected, context );
+    }
+
+    for ( const auto& pattern : patternsOf( list._words ) )
+    {
+      std::vector< std::string > expected;
+      for ( const auto& word : sorted )
+        if ( globMatches( pattern, word ) )
+          expected.push_back( word );
+      CHECK_FOR( trie.findPatternMatches( pattern ) == expected,
+          list._name + ", pattern " + test_n::quote( pattern ) );
+    }
+
+    // the brute force is quadratic, a sample of the prefixes does
+    const std::vector< std::string > prefixes = prefixesOf( list._words );
+    for ( size_t i = 0; i < prefixes.size(); i += 1 + prefixes.size() / 20 )
+    {
+      const std::string& prefix = prefixes[ i ];
+      for ( const uint32_t maxEdits : { 1u, 2u } )
+      {
+        std::vector< std::string > expected;
+        for ( const auto& word : sorted )
+          if ( fuzzyMatches( prefix, word, maxEdits ) )
+            expected.push_back( word );
+        CHECK_FOR( trie.findFuzzyPrefixMatches( prefix, maxEdits ) == expected,
+            list._name + ", fuzzy prefix " + test_n::quote( prefix ) );
+      }
+    }
+
+    Trie_c released( 1, TrieLayout_t::Radix );
+    for ( const auto& word : list._words )
+      released.insertWord( word );
+    released.freeze();
+    CHECK_FOR( !released.hasArena(), list._name );
+    CHECK_FOR( throwsLogicError( [ & ] { released.topK( "", 1 ); } ), list._name + ", topK" );
+    CHECK_FOR( throwsLogicError( [ & ] { released.cursor( "" ); } ), list._name + ", cursor" );
+    CHECK_FOR( throwsLogicError( [ & ] { released.findFuzzyPrefixMatches( "", 1 ); } ),
+        list._name + ", fuzzy" );
+    CHECK_FOR( throwsLogicError( [ & ] { released.findPatternMatches( "*" ); } ),
+        list._name + ", pattern" );
+
+    // from a query callback, which may run on one of the trie's own workers
+    std::promise< std::vector< std::string > > fromCallback;
+    QuerySession_c session( trie );
+    session.setCallback( [ & ]( const std::vector< std::string >& )
+    {
+      fromCallback.set_value( trie.findPatternMatches( "*" ) );
+    } );
+    session.findPrefixMatches( "" );
+    CHECK_FOR( fromCallback.get_future().get() == sorted, list._name + ", pattern from a callback" );
+  }
+
+  std::string readFile( const std::string& path )
+  {
+    std::ifstream in( path, std::ios::binary );
+    return std::string( std::istreambuf_iterator< char >( in ), std::istreambuf_iterator< char >() );
+  }
+
+  void testImages( const WordList_t& list )
+  {
+    const std::string path = ( std::filesystem::temp_directory_path() / "trie_test.img" ).string();
+
+    // straight from the arena
+    const auto plain = buildTrie( list._words, TrieLayout_t::Plain );
+    plain->save( path );
+    Trie_c reopened;
+    reopened.open( path );
+    CHECK_FOR( reopened.isFrozen(), list._name );
+    checkTrie( "image", reopened, list );
+
+    // from a trie frozen as double array
+    const auto radix = buildTrie( list._words, TrieLayout_t::Radix );
+    radix->freeze( FrozenLayout_t::DoubleArray );
+    radix->save( path );
+    Trie_c reopenedRadix;
+    reopenedRadix.open( path );
+    checkTrie( "double array image", reopenedRadix, list );
+
+    // images of the same trie are identical, byte by byte
+    const auto again = buildTrie( list._words, TrieLayout_t::Radix );
+    again->freeze( FrozenLayout_t::DoubleArray );
+    const std::string pathAgain = path + ".again";
+    again->save( pathAgain );
+    CHECK_FOR( readFile( path ) == readFile( pathAgain ), list._name );
+
+    std::remove( path.c_str() );
+    std::remove( pathAgain.c_str() );
+  }
+
+  void writeFile( const std::string& path, const std::string& content )
+  {
+    std::ofstream out( path, std::ios::binary | std::ios::trunc );
+    out.write( content.data(), static_cast< std::streamsize >( content.size() ) );
+  }
+
+  // the file is scanned in chunks on the trie's workers, one word per line
+  void testDictionary( const WordList_t& list )
+  {
+    const std::string path = ( std::filesystem::temp_directory_path() / "trie_test.txt" ).string();
+    std::string text;
+    for ( const auto& word : list._words )
+      text += word + "\n";
+    std::ofstream( path, std::ios::binary ) << text;
+
+    std::shared_ptr< const DeletionIndex_c > corrections;
+    {
+      Dictionary_c dictionary;
+      const LoadStats_t stats = dictionary.initDictionary( path, DeletionIndexConfig_t() );
+      CHECK_FOR( stats._words == list._words.size(), list._name );
+      CHECK_FOR( stats._bytes == text.size(), list._name );
+      checkTrie( "dictionary", *dictionary._trie, list );
+      corrections = dictionary._corrections;
+    }
+    std::remove( path.c_str() );
+
+    // the index keeps the mapped file alive, its ids are line numbers
+    CHECK_FOR( corrections && corrections->wordCount() == list._words.size(), list._name );
+    for ( size_t line = 0; corrections && line < list._words.size(); line += 1 + list._words.size() / 50 )
+    {
+      const std::vector< Suggestion_t > exact = corrections->lookup( list._words[ line ], 0 );
+      CHECK_FOR( exact.size() == 1 && exact[ 0 ]._word == list._words[ line ]
+          && list._words[ exact[ 0 ]._id ] == list._words[ line ] && exact[ 0 ]._id <= line,
+          list._name + ", line " + std::to_string( line ) );
+    }
+
+    bool threw = false;
+    try
+    {
+      Dictionary_c missing;
+      missing.initDictionary( path );
+    }
+    catch ( const std::runtime_error& )
+    {
+      threw = true;
+    }
+    CHECK_FOR( threw, list._name );
+
+    // CRLF lines with weights; a weight that does not parse counts as 1
+    const char* const malformed[] = { "", "x7", "12abc", "-3", "99999999999" };
+    std::map< std::string, uint32_t > weights;
+    text.clear();
+    for ( size_t i = 0; i < list._words.size(); ++i )
+    {
+      const std::string& word = list._words[ i ];
+      uint32_t weight = 1;
+      text += word;
+      if ( i % 3 == 0 )
+      {
+        weight = weightOf( word );
+        text += "\t" + std::to_string( weight );
+      }
+      else if ( i % 3 == 1 )
+      {
+        text += std::string( "\t" ) + malformed[ i % std::size( malformed ) ];
+      }
+      text += "\r\n";
+      uint32_t& kept = weights[ word ];
+      kept = std::max( kept, weight );
+    }
+    std::ofstream( path, std::ios::binary ) << text;
+
+    Dictionary_c weighted;
+    CHECK_FOR( weighted.initDictionary( path )._words == list._words.size(), list._name );
+    std::remove( path.c_str() );
+    checkTrie( "weighted dictionary", *weighted._trie, list );
+    const std::vector< std::string > prefixes = prefixesOf( list._words );
+    for ( size_t i = 0; i < prefixes.size(); i += 1 + prefixes.size() / 100 )
+    {
+      const std::string& prefix = prefixes[ i ];
+      const std::string context = list._name + ", weighted, prefix " + test_n::quote( prefix );
+      std::vector< uint32_t > expected;
+      for ( auto it = weights.lower_bound( prefix );
+          it != weights.end() && it->first.compare( 0, prefix.size(), prefix ) == 0; ++it )
+        expected.push_back( it->second );
+      std::sort( expected.rbegin(), expected.rend() );
+      expected.resize( std::min< size_t >( expected.size(), 5 ) );
+
+      const std::vector< ScoredWord_t > best = weighted._trie->topK( prefix, 5 );
+      CHECK_FOR( best.size() == expected.size(), context );
+      for ( size_t j = 0; j < best.size() && j < expected.size(); ++j )
+        CHECK_FOR( best[ j ]._weight == expected[ j ]
+            && best[ j ]._weight == weights[ best[ j ]._word ], context );
+    }
+  }
+
+  uint32_t editDistance( std::string_view a, std::string_view b )
+  {
+    std::vector< std::vector< uint32_t > > table( a.size() + 1, std::vector< uint32_t >( b.size() + 1 ) );
+    for ( size_t i = 0; i <= a.size(); ++i )
+      for ( size_t j = 0; j <= b.size(); ++j )
+        table[ i ][ j ] = i == 0 || j == 0 ? static_cast< uint32_t >( i + j )
+          : std::min( { table[ i - 1 ][ j ] + 1, table[ i ][ j - 1 ] + 1,
+              table[ i - 1 ][ j - 1 ] + ( a[ i - 1 ] == b[ j - 1 ] ? 0 : 1 ) } );
+    return table[ a.size() ][ b.size() ];
+  }
+
+  /*!
+    Every suggestion must be the first occurrence of a word within the
+    distance. Words of up to 7 bytes are indexed whole, so for them and a
+    query as short, every word within the distance must be suggested.
+    */
+  void testCorrections( const WordList_t& list )
+  {
+    const DeletionIndex_c index( std::vector< std::string_view >( list._words.begin(), list._words.end() ) );
+    CHECK_FOR( index.maxDistance() == 2, list._name );
+    // the budget bounds the build, so what is built stays within it
+    DeletionIndexConfig_t tight;
+    tight._memoryBudget = index.memoryUsage();
+    try
+    {
+      const DeletionIndex_c smaller( std::vector< std::string_view >( list._words.begin(), list._words.end() ),
+          tight );
+      CHECK_FOR( smaller.memoryUsage() <= tight._memoryBudget, list._name );
+      CHECK_FOR( smaller.maxDistance() < 2, list._name );
+    }
+    catch ( const std::length_error& )
+    {
+    }
+    std::map< std::string_view, uint32_t > firstIds;
+    for ( size_t id = 0; id < list._words.size(); ++id )
+      firstIds.emplace( list._words[ id ], static_cast< uint32_t >( id ) );
+
+    std::vector< std::string > queries;
+    for ( size_t i = 0; i < list._words.size(); i += 1 + list._words.size() / 30 )
+    {
+      const std::string& word = list._words[ i ];
+      queries.push_back( word );
+      queries.push_back( word + "x" );
+      if ( !word.empty() )
+        queries.push_back( "q" + word.substr( 1 ) );
+    }
+
+    for ( const auto& query : queries )
+      for ( const uint32_t maxEdits : { 1u, 2u } )
+      {
+        const std::string context = list._name + ", query " + test_n::quote( query );
+        const std::vector< Suggestion_t > suggestions = index.lookup( query, maxEdits );
+        std::map< std::string_view, uint32_t > found;
+        for ( size_t i = 0; i < suggestions.size(); ++i )
+        {
+          const Suggestion_t& suggestion = suggestions[ i ];
+          CHECK_FOR( suggestion._id < list._words.size()
+              && list._words[ suggestion._id ] == suggestion._word, context );
+          CHECK_FOR( firstIds[ suggestion._word ] == suggestion._id, context );
+          CHECK_FOR( suggestion._distance == editDistance( query, suggestion._word )
+              && suggestion._distance <= maxEdits, context );
+          CHECK_FOR( i == 0 || suggestions[ i - 1 ]._distance < suggestion._distance
+              || ( suggestions[ i - 1 ]._distance == suggestion._distance
+                && suggestions[ i - 1 ]._word < suggestion._word ), context );
+          found.emplace( suggestion._word, suggestion._id );
+        }
+
+        if ( query.size() > 7 )
+          continue;
+        for ( const auto& [ word, id ] : firstIds )
+          if ( word.size() <= 7 && editDistance( query, word ) <= maxEdits )
+            CHECK_FOR( found.count( word ) == 1, context + ", word " + test_n::quote( std::string( word ) ) );
+      }
+  }
+
+  // damaged images are rejected up front or served without reading out of
+  // bounds, whatever their units say
+  void testCorruptImages( const WordList_t& list )
+  {
+    const std::string path = ( std::filesystem::temp_directory_path() / "trie_test_corrupt.img" ).string();
+    buildTrie( list._words, TrieLayout_t::Radix )->save( path );
+    const std::string image = readFile( path );
+
+    for ( const size_t size : { size_t( 0 ), size_t( 20 ), size_t( 44 ), image.size() - 1 } )
+    {
+      writeFile( path, image.substr( 0, size ) );
+      bool rejected = false;
+      try
+      {
+        Trie_c truncated;
+        truncated.open( path );
+      }
+      catch ( const std::runtime_error& )
+      {
+        rejected = true;
+      }
+      CHECK_FOR( rejected, list._name + ", truncated to " + std::to_string( size ) );
+    }
+
+    using DaUnit_t = DoubleArrayTrie_c::DaUnit_t;
+    TrieImageHeader_t header;
+    std::memcpy( &header, image.data(), sizeof( header ) );
+    const size_t rootAt = header._payloadOffset;
+    DaUnit_t root;
+    std::memcpy( &root, image.data() + rootAt, sizeof( root ) );
+
+    // a root that names a parent, or has children in front of it
+    for ( const auto& [ base, check ] : { std::make_pair( root._base, 0 ), std::make_pair( 0, root._check ) } )
+    {
+      DaUnit_t broken = root;
+      broken._base = base;
+      broken._check = check;
+      std::string damaged = image;
+      std::memcpy( &damaged[ rootAt ], &broken, sizeof( broken ) );
+      writeFile( path, damaged );
+      bool rejected = false;
+      try
+      {
+        Trie_c badRoot;
+        badRoot.open( path );
+      }
+      catch ( const std::runtime_error& )
+      {
+        rejected = true;
+      }
+      CHECK_FOR( rejected || root._firstChild == DoubleArrayTrie_c::kNoLabel,
+          list._name + ", root base " + std::to_string( base ) + " check " + std::to_string( check ) );
+    }
+
+    // the first child of the root names itself as its next sibling
+    if ( root._firstChild != DoubleArrayTrie_c::kNoLabel )
+    {
+      const size_t childAt = rootAt + ( size_t( root._base ) + root._firstChild ) * sizeof( DaUnit_t );
+      DaUnit_t child;
+      std::memcpy( &child, image.data() + childAt, sizeof( child ) );
+      child._nextSibling = root._firstChild;
+      std::string looping = image;
+      std::memcpy( &looping[ childAt ], &child, sizeof( child ) );
+      writeFile( path, looping );
+
+      Trie_c loops;
+      loops.open( path );
+      const std::string first( 1, static_cast< char >( root._firstChild ) );
+      std::vector< std::string > matches;
+      loops.collectPrefixMatches( "", matches );
+      CHECK_FOR( matches.size() == loops.countPrefixMatches( first ) + ( root._isLeaf ? 1 : 0 ), list._name );
+      CHECK_FOR( loops.findPrefixMatches( "", 3, size_t( 1 ) )._words.size() <= 3, list._name );
+      CHECK_FOR( loops.findPrefixMatches( "", 3, first )._words.size() <= 3, list._name );
+    }
+
+    // anything behind the root
+    std::string damaged = image;
+    std::mt19937 rng( 7 );
+    for ( size_t i = rootAt + sizeof( DaUnit_t ); i < damaged.size(); i += 1 + rng() % 29 )
+      damaged[ i ] = static_cast< char >( rng() );
+    writeFile( path, damaged );
+
+    bool rejected = false;
+    try
+    {
+      Trie_c verified;
+      verified.open( path, true );
+    }
+    catch ( const std::runtime_error& )
+    {
+      rejected = true;
+    }
+    CHECK_FOR( rejected, list._name + ", checksum" );
+
+    Trie_c unverified;
+    unverified.open( path );
+    for ( const auto& prefix : prefixesOf( list._words ) )
+    {
+      std::vector< std::string > matches;
+      unverified.collectPrefixMatches( prefix, matches );
+      for ( const auto& match : matches )
+        CHECK_FOR( match.compare( 0, prefix.size(), prefix ) == 0, test_n::quote( prefix ) );
+      unverified.countPrefixMatches( prefix );
+      unverified.findPrefixMatches( prefix, 5, size_t( 2 ) );
+      unverified.findPrefixMatches( prefix, 5, prefix + "a" );
+    }
+    std::remove( path.c_str() );
+  }
+}
+
+int main( int argc, char** argv )
+{
+  testForEachThrows();
+  for ( const auto& list : wordLists( argc, argv ) )
+  {
+    testLayouts( list );
+    testBulkBuilds( list );
+    testFrozen( list );
+    testWithoutWorkers( list );
+    testArenaQueries( list );
+    testImages( list );
+    testDictionary( list );
+    testCorrections( list );
+    testCorruptImages( list );
+  }
+  return test_n::result( "trie_test" );
+}